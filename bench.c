@@ -0,0 +1,521 @@
+//
+// GOL_bench : cells per second of every simulation kernel over a sweep of board sizes, as CSV.
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <errno.h>
+
+#include "conway.h"
+#include "bitlife.h"
+#include "lifelut.h"
+#include "vectorized.h"
+#include "temporal.h"
+#include "wolfram.h"
+#include "smoothlife.h"
+#include "lenia.h"
+#include "rafler.h"
+#include "workers.h"
+#include "timing.h"
+
+// the buffers of one kernel at one size
+struct Bench {
+    int height;
+    int width;
+    struct WorkerPool *pool;
+    void *data; // float boards, the layout of the kernel
+    void *newData;
+    void *scratch;
+    struct BitGrid grid;
+    struct BitGrid newGrid;
+    struct BitRuleKernel kernel;
+    struct LifeLut *lut;
+    struct TemporalBlocking blocking;
+    struct TemporalScratch tiles; // conway_temporal, per worker
+    struct WolfRow row; // wolfram_bits and the radius-r kernels
+    struct WolfRow newRow;
+    struct WolfKernel wolf;
+    int generations; // per step
+};
+
+struct BenchKernel {
+    char const *name;
+    int max_side; // bigger boards are skipped, 0 : none
+    int min_side; // smaller ones too
+    int fixed_side; // the kernel only knows this size, 0 : any
+    bool (*setup)(struct Bench *bench);
+    void (*step)(struct Bench *bench);
+};
+
+static void SwapData(struct Bench *bench)
+{
+    void *tmp = bench->data;
+    bench->data = bench->newData;
+    bench->newData = tmp;
+}
+
+static void SwapGrids(struct Bench *bench)
+{
+    struct BitGrid const tmp = bench->grid;
+    bench->grid = bench->newGrid;
+    bench->newGrid = tmp;
+}
+
+static bool SetupConwayFloat(struct Bench *bench)
+{
+    int const height = bench->height, width = bench->width;
+    bench->data = malloc(sizeof(float[height][width][2]));
+    bench->newData = malloc(sizeof(float[height][width][2]));
+    if (bench->data == NULL || bench->newData == NULL)
+        return false;
+    InitConway(height, width, bench->data, 90);
+    return true;
+}
+
+static void ConwayFloatBand(void *context, int const begin, int const end)
+{
+    struct Bench *bench = context;
+    IterateConwayRows(bench->height, bench->width, bench->data, bench->newData, CONWAY_LIFE_RULE, begin, end);
+}
+
+static void StepConwayFloat(struct Bench *bench)
+{
+    RunBands(bench->pool, bench->height, ConwayFloatBand, bench);
+    SwapData(bench);
+}
+
+static void ConwaySimdBand(void *context, int const begin, int const end)
+{
+    struct Bench *bench = context;
+    IterateConwayVectorizedRows(bench->height, bench->width, bench->data, bench->newData, begin, end);
+}
+
+static void StepConwaySimd(struct Bench *bench)
+{
+    RunBands(bench->pool, bench->height, ConwaySimdBand, bench);
+    SwapData(bench);
+}
+
+static bool SetupConwayTemporal(struct Bench *bench)
+{
+    bench->blocking = ChooseTemporalBlocking(bench->height, bench->width, 0);
+    bench->generations = bench->blocking.generations;
+    if (bench->blocking.generations > 1
+        && !CreateTemporalScratch(&bench->tiles, bench->blocking, WorkerCount(bench->pool)))
+        return false;
+    return SetupConwayFloat(bench);
+}
+
+static void ConwayTemporalBand(void *context, int const worker, int const begin, int const end)
+{
+    struct Bench *bench = context;
+    IterateConwayBlocks(bench->height, bench->width, bench->data, bench->newData, NULL, bench->blocking,
+                        bench->blocking.generations, &bench->tiles, worker, begin, end);
+}
+
+// conway_simd with as many generations per pass as fit in L2, one pass per step
+static void StepConwayTemporal(struct Bench *bench)
+{
+    if (bench->blocking.generations > 1)
+        RunWorkerBands(bench->pool, TemporalTiles(bench->height, bench->width, bench->blocking), ConwayTemporalBand,
+                       bench);
+    else
+        RunBands(bench->pool, bench->height, ConwaySimdBand, bench);
+    SwapData(bench);
+}
+
+static bool SetupConwayBits(struct Bench *bench)
+{
+    bench->grid = CreateBitGrid(bench->height, bench->width);
+    bench->newGrid = CreateBitGrid(bench->height, bench->width);
+    if (bench->grid.cells == NULL || bench->newGrid.cells == NULL)
+        return false;
+    InitBitLife(&bench->grid, 90);
+    bench->kernel = SelectBitRuleKernel(CONWAY_LIFE_RULE);
+    return true;
+}
+
+static void ConwayBitsBand(void *context, int const begin, int const end)
+{
+    struct Bench *bench = context;
+    IterateBitRuleRows(&bench->kernel, &bench->grid, &bench->newGrid, begin, end);
+}
+
+// every tile, the tile skipping of LaunchConway would measure the soup rather than the kernel
+static void StepConwayBits(struct Bench *bench)
+{
+    RunBands(bench->pool, bench->height, ConwayBitsBand, bench);
+    SwapGrids(bench);
+}
+
+static bool SetupConwayLut(struct Bench *bench)
+{
+    bench->lut = malloc(sizeof *bench->lut);
+    if (bench->lut == NULL || !SetupConwayBits(bench))
+        return false;
+    BuildLifeLut(bench->lut, CONWAY_LIFE_RULE);
+    return true;
+}
+
+static void ConwayLutBand(void *context, int const begin, int const end)
+{
+    struct Bench *bench = context;
+    IterateBitLifeLut4Pairs(bench->lut, &bench->grid, &bench->newGrid, begin, end);
+}
+
+static void StepConwayLut(struct Bench *bench)
+{
+    RunBands(bench->pool, (bench->height + 1) / 2, ConwayLutBand, bench);
+    SwapGrids(bench);
+}
+
+static bool SetupWolfram(struct Bench *bench)
+{
+    bench->data = malloc(sizeof(float[bench->height][bench->width][2]));
+    if (bench->data == NULL)
+        return false;
+    InitWolf(bench->height, bench->width, bench->data, 30);
+    return true;
+}
+
+// one step fills the whole board, height rows of the rule
+static void StepWolfram(struct Bench *bench)
+{
+    for (int line = 0; line < bench->height; ++line)
+        IterateWolf(bench->height, bench->width, bench->data, 30, line);
+}
+
+static bool SetupWolfRow(struct Bench *bench, char const *rule)
+{
+    struct WolfRule parsed;
+    if (!ParseWolfRule(rule, &parsed))
+        return false;
+    bench->wolf = SelectWolfKernel(parsed);
+    bench->row = CreateWolfRow(bench->width);
+    bench->newRow = CreateWolfRow(bench->width);
+    if (bench->row.cells == NULL || bench->newRow.cells == NULL)
+        return false;
+    InitWolfRow(&bench->row);
+    return true;
+}
+
+static bool SetupWolframBits(struct Bench *bench)
+{
+    return SetupWolfRow(bench, "W30");
+}
+
+// the totalistic code 54 of radius 2, it grows from the single cell
+static bool SetupWolframTotalistic(struct Bench *bench)
+{
+    return SetupWolfRow(bench, "R2/T54");
+}
+
+static bool SetupWolframOuter(struct Bench *bench)
+{
+    return SetupWolfRow(bench, "R3/B1/S012");
+}
+
+// as many cells as wolfram, height generations of one row
+static void StepWolframBits(struct Bench *bench)
+{
+    for (int line = 0; line < bench->height; ++line) {
+        StepWolfKernel(&bench->wolf, &bench->row, &bench->newRow);
+        struct WolfRow const tmp = bench->row;
+        bench->row = bench->newRow;
+        bench->newRow = tmp;
+    }
+}
+
+static bool SetupSmooth(struct Bench *bench)
+{
+    int const height = bench->height, width = bench->width;
+    bench->data = malloc(sizeof(float[height][width]));
+    bench->newData = malloc(sizeof(float[height][width]));
+    if (bench->data == NULL || bench->newData == NULL)
+        return false;
+    InitSmoothworld(height, width, bench->data, 90, bench->pool);
+    return true;
+}
+
+static void StepSmooth(struct Bench *bench)
+{
+    StepSmoothWorld(bench->height, bench->width, bench->data, bench->newData, bench->pool);
+    SwapData(bench);
+}
+
+static bool SetupLenia(struct Bench *bench)
+{
+    int const height = bench->height, width = bench->width;
+    bench->data = malloc(sizeof(float[height][width]));
+    bench->newData = malloc(sizeof(float[height][width]));
+    bench->scratch = malloc(sizeof(float[height][width]));
+    if (bench->data == NULL || bench->newData == NULL || bench->scratch == NULL)
+        return false;
+    InitKernel(128);
+    InitLenia(height, width, bench->data, 90);
+    return true;
+}
+
+static void StepLenia(struct Bench *bench)
+{
+    Convolve(bench->height, bench->width, bench->data, bench->scratch);
+    ApplyGrowth(bench->height, bench->width, bench->scratch, bench->newData);
+    SwapData(bench);
+}
+
+static bool SetupRafler(struct Bench *)
+{
+    initialize_field_with_life();
+    return true;
+}
+
+static void StepRafler(struct Bench *)
+{
+    step();
+}
+
+static bool SetupMandel(struct Bench *bench)
+{
+    bench->data = malloc(sizeof(float[bench->height][bench->width]));
+    return bench->data != NULL;
+}
+
+// the fragment shader of mandel.cpp on the CPU, at its starting zoom and iteration count
+static void MandelRows(void *context, int const begin, int const end)
+{
+    struct Bench *bench = context;
+    int const height = bench->height, width = bench->width, max_iter = 100;
+    float const zoom = 2.0f;
+    float (*out)[height][width] = bench->data;
+
+    for (int row = begin; row < end; ++row) {
+        for (int column = 0; column < width; ++column) {
+            float const cx = ((column + 0.5f) / width - 0.5f) * zoom;
+            float const cy = ((row + 0.5f) / height - 0.5f) * zoom;
+            float zx = 0, zy = 0;
+            int iter;
+            for (iter = 0; iter < max_iter; iter++) {
+                float const x = zx * zx - zy * zy + cx;
+                float const y = 2.0f * zx * zy + cy;
+                if (x * x + y * y > 4.0f)
+                    break;
+                zx = x;
+                zy = y;
+            }
+            (*out)[row][column] = (float)iter / max_iter;
+        }
+    }
+}
+
+static void StepMandel(struct Bench *bench)
+{
+    RunBands(bench->pool, bench->height, MandelRows, bench);
+}
+
+static struct BenchKernel const KERNELS[] = {
+    {"conway_float", 0, 0, 0, SetupConwayFloat, StepConwayFloat},
+    {"conway_simd", 0, 0, 0, SetupConwayFloat, StepConwaySimd},
+    {"conway_temporal", 0, 0, 0, SetupConwayTemporal, StepConwayTemporal},
+    {"conway_bits", 0, 0, 0, SetupConwayBits, StepConwayBits},
+    {"conway_lut", 0, 0, 0, SetupConwayLut, StepConwayLut},
+    {"wolfram", 0, 0, 0, SetupWolfram, StepWolfram},
+    {"wolfram_bits", 0, 0, 0, SetupWolframBits, StepWolframBits},
+    {"wolfram_t2", 0, 0, 0, SetupWolframTotalistic, StepWolframBits},
+    {"wolfram_ot3", 0, 0, 0, SetupWolframOuter, StepWolframBits},
+    {"smoothworld", 0, 0, 0, SetupSmooth, StepSmooth},
+    // a 128 x 128 convolution per cell, and it wraps around only once
+    {"lenia", 512, 64, 0, SetupLenia, StepLenia},
+    {"rafler", 0, 0, FIELD_SIZE, SetupRafler, StepRafler},
+    {"mandel", 0, 0, 0, SetupMandel, StepMandel},
+};
+
+static void FreeBench(struct Bench *bench)
+{
+    free(bench->data);
+    free(bench->newData);
+    free(bench->scratch);
+    free(bench->lut);
+    FreeBitGrid(&bench->grid);
+    FreeBitGrid(&bench->newGrid);
+    FreeWolfRow(&bench->row);
+    FreeWolfRow(&bench->newRow);
+    FreeTemporalScratch(&bench->tiles);
+}
+
+static int CompareSeconds(void const *a, void const *b)
+{
+    double const x = *(double const *)a, y = *(double const *)b;
+    return (x > y) - (x < y);
+}
+
+static void Usage(char const *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --kernels a,b,...     among conway_float, conway_simd, conway_temporal, conway_bits, conway_lut,\n"
+            "                        wolfram, wolfram_bits, wolfram_t2, wolfram_ot3, smoothworld, lenia, rafler\n"
+            "                        and mandel (all of them)\n"
+            "  --sizes a,b,...       1024 for a square board or 640x480 (256,640x480,1024,2048)\n"
+            "  --threads N           0 : every hardware thread (1)\n"
+            "  --warmup N            runs thrown away first (1)\n"
+            "  --repeats N           timed runs, the median is reported (5)\n"
+            "  --min-time S          seconds a run lasts at least, steps are doubled until it does (0.1)\n",
+            program);
+    exit(EXIT_FAILURE);
+}
+
+// a whole number up to the end of text or the next comma, the usage otherwise
+static int ParseNumber(char const *program, char const *text)
+{
+    char *end;
+    errno = 0;
+    long const value = strtol(text, &end, 10);
+    if (end == text || (*end != '\0' && *end != ',') || errno == ERANGE || value < 0 || value > INT_MAX)
+        Usage(program);
+    return (int)value;
+}
+
+// "1024" or "640x480" up to the end of text or the next comma, the usage otherwise
+static void ParseSize(char const *program, char const *text, int *width, int *height)
+{
+    char *end;
+    errno = 0;
+    long const columns = strtol(text, &end, 10);
+    long rows = columns;
+    if (end != text && *end == 'x') {
+        char const *second = end + 1;
+        rows = strtol(second, &end, 10);
+        if (end == second)
+            Usage(program);
+    }
+    if (end == text || (*end != '\0' && *end != ',') || errno == ERANGE
+        || columns <= 0 || rows <= 0 || columns > INT_MAX || rows > INT_MAX)
+        Usage(program);
+    *width = (int)columns;
+    *height = (int)rows;
+}
+
+static double ParseSeconds(char const *program, char const *text)
+{
+    char *end;
+    double const value = strtod(text, &end);
+    if (end == text || *end != '\0' || !(value > 0))
+        Usage(program);
+    return value;
+}
+
+static bool InList(char const *list, char const *name)
+{
+    size_t const length = strlen(name);
+    for (char const *item = list; item != NULL; item = strchr(item, ',') ? strchr(item, ',') + 1 : NULL)
+        if (strncmp(item, name, length) == 0 && (item[length] == ',' || item[length] == '\0'))
+            return true;
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    char const *kernels = NULL;
+    char const *sizes = "256,640x480,1024,2048";
+    int threads = 1, warmup = 1, repeats = 5;
+    double min_time = 0.1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--kernels") == 0)
+            kernels = argv[i + 1];
+        else if (strcmp(argv[i], "--sizes") == 0)
+            sizes = argv[i + 1];
+        else if (strcmp(argv[i], "--threads") == 0)
+            threads = ParseNumber(argv[0], argv[i + 1]);
+        else if (strcmp(argv[i], "--warmup") == 0)
+            warmup = ParseNumber(argv[0], argv[i + 1]);
+        else if (strcmp(argv[i], "--repeats") == 0)
+            repeats = ParseNumber(argv[0], argv[i + 1]);
+        else if (strcmp(argv[i], "--min-time") == 0)
+            min_time = ParseSeconds(argv[0], argv[i + 1]);
+        else
+            Usage(argv[0]);
+    }
+    if (argc % 2 == 0 || repeats <= 0 || warmup < 0 || min_time <= 0)
+        Usage(argv[0]);
+    for (char const *size = sizes; size != NULL; size = strchr(size, ',') ? strchr(size, ',') + 1 : NULL) {
+        int width, height;
+        ParseSize(argv[0], size, &width, &height);
+    }
+
+    struct WorkerPool *pool = CreateWorkerPool(threads);
+    double *seconds = malloc(repeats * sizeof *seconds);
+    if (pool == NULL || seconds == NULL) {
+        fprintf(stderr, "fail to start the worker pool\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("# simd %s, %d workers, %d hardware threads\n", VectorKernelName(), WorkerCount(pool),
+           HardwareThreadCount());
+    printf("kernel,width,height,threads,steps,repeats,median_seconds,best_seconds,"
+           "median_cells_per_second,best_cells_per_second\n");
+
+    for (size_t k = 0; k < sizeof KERNELS / sizeof *KERNELS; ++k) {
+        struct BenchKernel const *kernel = &KERNELS[k];
+        if (kernels != NULL && !InList(kernels, kernel->name))
+            continue;
+
+        for (char const *size = sizes; size != NULL; size = strchr(size, ',') ? strchr(size, ',') + 1 : NULL) {
+            int width, height;
+            if (kernel->fixed_side != 0)
+                width = height = kernel->fixed_side;
+            else
+                ParseSize(argv[0], size, &width, &height);
+            if ((kernel->max_side != 0 && (width > kernel->max_side || height > kernel->max_side))
+                || width < kernel->min_side || height < kernel->min_side)
+                continue;
+
+            struct Bench bench = {.height = height, .width = width, .pool = pool, .generations = 1};
+            if (!kernel->setup(&bench)) {
+                fprintf(stderr, "fail to allocate %s at %d x %d\n", kernel->name, width, height);
+                exit(EXIT_FAILURE);
+            }
+
+            // enough steps per run for the clock to be meaningless, found while warming up
+            uint64_t steps = 1;
+            for (;;) {
+                double const start = WallSeconds();
+                for (uint64_t s = 0; s < steps; ++s)
+                    kernel->step(&bench);
+                if (WallSeconds() - start >= min_time)
+                    break;
+                steps *= 2;
+            }
+            for (int w = 0; w < warmup; ++w)
+                for (uint64_t s = 0; s < steps; ++s)
+                    kernel->step(&bench);
+
+            for (int r = 0; r < repeats; ++r) {
+                double const start = WallSeconds();
+                for (uint64_t s = 0; s < steps; ++s)
+                    kernel->step(&bench);
+                seconds[r] = (WallSeconds() - start) / steps;
+            }
+            qsort(seconds, repeats, sizeof *seconds, CompareSeconds);
+
+            double const cells = (double)width * height * bench.generations;
+            double const median = repeats % 2 ? seconds[repeats / 2]
+                                              : (seconds[repeats / 2 - 1] + seconds[repeats / 2]) / 2;
+            printf("%s,%d,%d,%d,%llu,%d,%.9g,%.9g,%.6g,%.6g\n", kernel->name, width, height, WorkerCount(pool),
+                   (unsigned long long)steps, repeats, median, seconds[0], cells / median, cells / seconds[0]);
+            fflush(stdout);
+
+            FreeBench(&bench);
+            if (kernel->fixed_side != 0)
+                break;
+        }
+    }
+
+    free(seconds);
+    FreeWorkerPool(pool);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,362 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitlife.h"
+#include "lifeword.h"
+#include "rng.h"
+
+struct BitGrid CreateBitGrid(int const height, int const width)
+{
+    int const words = (width + 63) / 64;
+    struct BitGrid grid = {height, width, words, nullptr};
+
+    grid.cells = calloc((size_t)height * words, sizeof *grid.cells);
+
+    return grid;
+}
+
+void FreeBitGrid(struct BitGrid *grid)
+{
+    free(grid->cells);
+    grid->cells = nullptr;
+}
+
+// meme tirage que InitConway, pour pouvoir comparer les deux moteurs
+void InitBitLifeRows(struct BitGrid *grid, uint64_t const seed, int const begin, int const end)
+{
+    int const tail = grid->width % 64;
+    for (int y = begin; y < end; ++y) {
+        uint64_t *row = grid->cells + (long)y * grid->words;
+        for (int j = 0; j < grid->words; ++j)
+            row[j] = RandomCellWord(seed, y, j * 64);
+        if (tail != 0)
+            row[grid->words - 1] &= ((uint64_t)1 << tail) - 1;
+    }
+}
+
+void InitBitLife(struct BitGrid *grid, uint64_t const seed)
+{
+    InitBitLifeRows(grid, seed, 0, grid->height);
+}
+
+// cell x-1 aligned on x, wrapping around the torus on the first word
+static inline uint64_t West(uint64_t const *row, int const j, int const words, int const width)
+{
+    uint64_t const carry = j > 0
+            ? row[j - 1] >> 63
+            : row[words - 1] >> ((width - 1) % 64);
+    return row[j] << 1 | (carry & 1);
+}
+
+// cell x+1 aligned on x, the last valid bit of the row receives cell 0
+static inline uint64_t East(uint64_t const *row, int const j, int const words, int const width)
+{
+    if (j < words - 1)
+        return row[j] >> 1 | row[j + 1] << 63;
+    return row[j] >> 1 | (row[0] & 1) << ((width - 1) % 64);
+}
+
+// splitmix64 finaliser, 0 stays 0
+static inline uint64_t Mix64(uint64_t x)
+{
+    x = (x ^ x >> 30) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ x >> 27) * 0x94D049BB133111EBull;
+    return x ^ x >> 31;
+}
+
+// the grid hash is the sum of every word mixed with the key of its place, a Zobrist table without the table;
+// each bit of a word reaches every bit of its term, a changed word moves the sum by the difference of two terms
+static inline uint64_t WordTerm(uint64_t const word, long const index)
+{
+    return Mix64(word ^ Mix64((uint64_t)index + 0x9E3779B97F4A7C15ull));
+}
+
+RULE_INLINE uint64_t LifeWordAt(
+        uint16_t const birth, uint16_t const survival,
+        uint64_t const *up, uint64_t const *row, uint64_t const *down,
+        int const j, int const words, int const width)
+{
+    return LifeWord(birth, survival,
+            West(up, j, words, width), up[j], East(up, j, words, width),
+            West(row, j, words, width), row[j], East(row, j, words, width),
+            West(down, j, words, width), down[j], East(down, j, words, width));
+}
+
+RULE_INLINE uint64_t LifeWordInterior(
+        uint16_t const birth, uint16_t const survival,
+        uint64_t const *up, uint64_t const *row, uint64_t const *down, int const j)
+{
+    return LifeWord(birth, survival,
+            up[j] << 1 | up[j - 1] >> 63, up[j], up[j] >> 1 | up[j + 1] << 63,
+            row[j] << 1 | row[j - 1] >> 63, row[j], row[j] >> 1 | row[j + 1] << 63,
+            down[j] << 1 | down[j - 1] >> 63, down[j], down[j] >> 1 | down[j + 1] << 63);
+}
+
+RULE_INLINE void IterateRuleRow(
+        uint16_t const birth, uint16_t const survival,
+        uint64_t const *up, uint64_t const *row, uint64_t const *down, uint64_t *out,
+        int const words, int const width)
+{
+    int const last = words - 1;
+    uint64_t const last_mask = width % 64 ? ~0ull >> (64 - width % 64) : ~0ull;
+
+    out[0] = LifeWordAt(birth, survival, up, row, down, 0, words, width);
+
+    // interior words need no wraparound
+    for (int j = 1; j < last; j++)
+        out[j] = LifeWordInterior(birth, survival, up, row, down, j);
+
+    if (last > 0)
+        out[last] = LifeWordAt(birth, survival, up, row, down, last, words, width);
+
+    out[last] &= last_mask;
+}
+
+RULE_INLINE void IterateRuleRows(
+        uint16_t const birth, uint16_t const survival,
+        struct BitGrid const *grid, struct BitGrid *newGrid, int const begin, int const end)
+{
+    int const height = grid->height;
+    int const words = grid->words;
+
+    for (int y = begin; y < end; ++y) {
+        IterateRuleRow(birth, survival,
+                grid->cells + (long)((y + height - 1) % height) * words,
+                grid->cells + (long)y * words,
+                grid->cells + (long)((y + 1) % height) * words,
+                newGrid->cells + (long)y * words,
+                words, grid->width);
+    }
+}
+
+// one tile of newGrid, true when it differs from the same tile of grid, the change of HashBitGrid into *hash
+RULE_INLINE bool IterateRuleTile(
+        uint16_t const birth, uint16_t const survival,
+        struct BitGrid const *grid, struct BitGrid *newGrid, int const ty, int const tx, uint64_t *hash)
+{
+    int const height = grid->height, width = grid->width, words = grid->words;
+    int const last = words - 1;
+    uint64_t const mask = tx == last && width % 64 ? ~0ull >> (64 - width % 64) : ~0ull;
+    int const end = ty * TILE_ROWS + TILE_ROWS < height ? ty * TILE_ROWS + TILE_ROWS : height;
+    uint64_t changed = 0;
+
+    for (int y = ty * TILE_ROWS; y < end; ++y) {
+        uint64_t const *up = grid->cells + (long)(y == 0 ? height - 1 : y - 1) * words;
+        uint64_t const *row = grid->cells + (long)y * words;
+        uint64_t const *down = grid->cells + (long)(y == height - 1 ? 0 : y + 1) * words;
+        int const j = tx;
+
+        uint64_t next;
+        if (j > 0 && j < last)
+            next = LifeWordInterior(birth, survival, up, row, down, j);
+        else
+            next = LifeWordAt(birth, survival, up, row, down, j, words, width) & mask;
+
+        newGrid->cells[(long)y * words + j] = next;
+        // only the words that changed touch the hash
+        if (next != row[j])
+            *hash += WordTerm(next, (long)y * words + j) - WordTerm(row[j], (long)y * words + j);
+        changed |= next ^ row[j];
+    }
+
+    return changed != 0;
+}
+
+RULE_INLINE void IterateRuleTileRows(
+        uint16_t const birth, uint16_t const survival,
+        struct BitGrid const *grid, struct BitGrid *newGrid, struct TileTracker *tiles,
+        int const begin, int const end)
+{
+    int const columns = tiles->columns;
+
+    for (int ty = begin; ty < end; ++ty) {
+        uint64_t hash = 0;
+        for (int tx = 0; tx < columns; ++tx) {
+            int const t = ty * columns + tx;
+            tiles->next_changed[t] = tiles->active[t]
+                    && IterateRuleTile(birth, survival, grid, newGrid, ty, tx, &hash);
+        }
+        tiles->hash_change[ty] = hash;
+    }
+}
+
+// one copy of the row and tile loops per rule, its masks folded in as constants
+#define BIT_RULE_KERNEL(name, birth, survival) \
+    static void IterateRows_##name(struct LifeRule const rule, struct BitGrid const *grid, \
+                                   struct BitGrid *newGrid, int const begin, int const end) \
+    { \
+        (void)rule; \
+        IterateRuleRows(birth, survival, grid, newGrid, begin, end); \
+    } \
+    static void IterateTileRows_##name(struct LifeRule const rule, struct BitGrid const *grid, \
+                                       struct BitGrid *newGrid, struct TileTracker *tiles, \
+                                       int const begin, int const end) \
+    { \
+        (void)rule; \
+        IterateRuleTileRows(birth, survival, grid, newGrid, tiles, begin, end); \
+    }
+
+SPECIALISED_RULES(BIT_RULE_KERNEL)
+
+// masks read at run time, still branch free, for the rules without their own copy
+static void IterateRows_Generic(struct LifeRule const rule, struct BitGrid const *grid,
+                                struct BitGrid *newGrid, int const begin, int const end)
+{
+    IterateRuleRows(rule.birth, rule.survival, grid, newGrid, begin, end);
+}
+
+static void IterateTileRows_Generic(struct LifeRule const rule, struct BitGrid const *grid,
+                                    struct BitGrid *newGrid, struct TileTracker *tiles,
+                                    int const begin, int const end)
+{
+    IterateRuleTileRows(rule.birth, rule.survival, grid, newGrid, tiles, begin, end);
+}
+
+#define SPECIALISED_ENTRY(name, birth, survival) \
+    {{birth, survival}, #name, true, IterateRows_##name, IterateTileRows_##name},
+
+static struct BitRuleKernel const specialised_kernels[] = {
+    SPECIALISED_RULES(SPECIALISED_ENTRY)
+};
+
+struct BitRuleKernel SelectBitRuleKernel(struct LifeRule const rule)
+{
+    for (size_t i = 0; i < sizeof specialised_kernels / sizeof *specialised_kernels; ++i) {
+        struct BitRuleKernel const *kernel = &specialised_kernels[i];
+        if (kernel->rule.birth == rule.birth && kernel->rule.survival == rule.survival)
+            return *kernel;
+    }
+
+    return (struct BitRuleKernel){rule, "generic", false, IterateRows_Generic, IterateTileRows_Generic};
+}
+
+void IterateBitRuleRows(struct BitRuleKernel const *kernel, struct BitGrid const *grid, struct BitGrid *newGrid,
+                        int const begin, int const end)
+{
+    kernel->rows(kernel->rule, grid, newGrid, begin, end);
+}
+
+void IterateBitRuleTileRows(struct BitRuleKernel const *kernel, struct BitGrid const *grid, struct BitGrid *newGrid,
+                            struct TileTracker *tiles, int const begin, int const end)
+{
+    kernel->tile_rows(kernel->rule, grid, newGrid, tiles, begin, end);
+}
+
+void IterateBitLifeRows(struct BitGrid const *grid, struct BitGrid *newGrid, int const begin, int const end)
+{
+    IterateRuleRows(CONWAY_BIRTH, CONWAY_SURVIVAL, grid, newGrid, begin, end);
+}
+
+void IterateBitLife(struct BitGrid const *grid, struct BitGrid *newGrid)
+{
+    IterateBitLifeRows(grid, newGrid, 0, grid->height);
+}
+
+long long CountBitLife(struct BitGrid const *grid)
+{
+    long long population = 0;
+    for (long i = 0; i < (long)grid->height * grid->words; ++i)
+        population += PopCount64(grid->cells[i]);
+    return population;
+}
+
+uint64_t HashBitGrid(struct BitGrid const *grid)
+{
+    uint64_t hash = 0;
+    for (long i = 0; i < (long)grid->height * grid->words; ++i)
+        hash += WordTerm(grid->cells[i], i);
+    return hash;
+}
+
+struct TileTracker CreateTileTracker(struct BitGrid const *grid)
+{
+    struct TileTracker tiles = {
+        .rows = (grid->height + TILE_ROWS - 1) / TILE_ROWS,
+        .columns = grid->words,
+    };
+    size_t const count = (size_t)tiles.rows * tiles.columns;
+
+    tiles.changed = malloc(count);
+    tiles.next_changed = calloc(count, 1);
+    tiles.active = malloc(count);
+    tiles.hash_change = calloc(tiles.rows, sizeof *tiles.hash_change);
+    if (tiles.changed == nullptr || tiles.next_changed == nullptr || tiles.active == nullptr
+        || tiles.hash_change == nullptr) {
+        FreeTileTracker(&tiles);
+        return tiles;
+    }
+    MarkAllTilesChanged(&tiles);
+
+    return tiles;
+}
+
+void FreeTileTracker(struct TileTracker *tiles)
+{
+    free(tiles->changed);
+    free(tiles->next_changed);
+    free(tiles->active);
+    free(tiles->hash_change);
+    tiles->changed = tiles->next_changed = tiles->active = nullptr;
+    tiles->hash_change = nullptr;
+}
+
+void MarkAllTilesChanged(struct TileTracker *tiles)
+{
+    memset(tiles->changed, 1, (size_t)tiles->rows * tiles->columns);
+    tiles->stepped = false;
+}
+
+int PrepareTiles(struct TileTracker *tiles)
+{
+    int const rows = tiles->rows, columns = tiles->columns;
+
+    // what the last generation wrote becomes what this one reads
+    if (tiles->stepped) {
+        uint8_t *tmp = tiles->changed;
+        tiles->changed = tiles->next_changed;
+        tiles->next_changed = tmp;
+    }
+    tiles->stepped = true;
+
+    int count = 0;
+    for (int ty = 0; ty < rows; ++ty) {
+        int const up = ty == 0 ? rows - 1 : ty - 1;
+        int const down = ty == rows - 1 ? 0 : ty + 1;
+        for (int tx = 0; tx < columns; ++tx) {
+            int const left = tx == 0 ? columns - 1 : tx - 1;
+            int const right = tx == columns - 1 ? 0 : tx + 1;
+            uint8_t const *above = tiles->changed + up * columns;
+            uint8_t const *row = tiles->changed + ty * columns;
+            uint8_t const *below = tiles->changed + down * columns;
+
+            bool const active = above[left] | above[tx] | above[right]
+                              | row[left] | row[tx] | row[right]
+                              | below[left] | below[tx] | below[right];
+            tiles->active[ty * columns + tx] = active;
+            count += active;
+        }
+    }
+    tiles->active_count = count;
+
+    return count;
+}
+
+void IterateBitLifeTileRows(struct BitGrid const *grid, struct BitGrid *newGrid, struct TileTracker *tiles,
+                            int const begin, int const end)
+{
+    IterateRuleTileRows(CONWAY_BIRTH, CONWAY_SURVIVAL, grid, newGrid, tiles, begin, end);
+}
+
+uint64_t TileHashChange(struct TileTracker const *tiles)
+{
+    uint64_t change = 0;
+    for (int ty = 0; ty < tiles->rows; ++ty)
+        change += tiles->hash_change[ty];
+    return change;
+}
+
+void IterateBitLifeTiles(struct BitGrid const *grid, struct BitGrid *newGrid, struct TileTracker *tiles)
+{
+    PrepareTiles(tiles);
+    IterateBitLifeTileRows(grid, newGrid, tiles, 0, tiles->rows);
+}
@@ -0,0 +1,96 @@
+//
+// Bit-packed Life engine, 64 cells per word, B3/S23 or any Life-like rule.
+//
+
+#ifndef GOL_BITLIFE_H
+#define GOL_BITLIFE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "liferule.h"
+
+// bit i of word j in a row is the cell x = 64 * j + i, bits past width stay 0
+struct BitGrid {
+    int height;
+    int width;
+    int words; // words per row
+    uint64_t *cells; // height * words
+};
+
+// one tile is TILE_ROWS rows of one word, 64x64 cells
+#define TILE_ROWS 64
+
+// which tiles changed during the last generation, shared by both buffers of a grid
+struct TileTracker {
+    int rows; // tiles
+    int columns;
+    uint8_t *changed;
+    uint8_t *next_changed;
+    uint8_t *active; // changed or next to a changed tile, recomputed by PrepareTiles
+    int active_count;
+    bool stepped;
+    uint64_t *hash_change; // per tile row, what the last generation added to HashBitGrid
+};
+
+struct BitGrid CreateBitGrid(int height, int width);
+void FreeBitGrid(struct BitGrid *grid);
+
+void InitBitLife(struct BitGrid *grid, uint64_t seed);
+// the soup of seed on rows [begin, end), cell (x, y) is RandomCell(seed, y, x) whoever fills which rows
+void InitBitLifeRows(struct BitGrid *grid, uint64_t seed, int begin, int end);
+void IterateBitLife(struct BitGrid const *grid, struct BitGrid *newGrid);
+// rows [begin, end) only, bands of rows can run on different threads
+void IterateBitLifeRows(struct BitGrid const *grid, struct BitGrid *newGrid, int begin, int end);
+long long CountBitLife(struct BitGrid const *grid);
+// 64 bit hash of the cells, the tile kernels keep it up to date from the words they change
+uint64_t HashBitGrid(struct BitGrid const *grid);
+
+struct TileTracker CreateTileTracker(struct BitGrid const *grid);
+void FreeTileTracker(struct TileTracker *tiles);
+// everything is recomputed on the next generation, for when the grid was written from outside
+void MarkAllTilesChanged(struct TileTracker *tiles);
+// once per generation before the tile rows, returns how many tiles will be computed
+int PrepareTiles(struct TileTracker *tiles);
+// tile rows [begin, end), tiles left inactive already hold the next generation in newGrid
+void IterateBitLifeTileRows(struct BitGrid const *grid, struct BitGrid *newGrid, struct TileTracker *tiles,
+                            int begin, int end);
+void IterateBitLifeTiles(struct BitGrid const *grid, struct BitGrid *newGrid, struct TileTracker *tiles);
+// HashBitGrid(newGrid) - HashBitGrid(grid) for the generation that just ran, without reading the grids
+uint64_t TileHashChange(struct TileTracker const *tiles);
+
+// steps any Life-like rule, the common ones have their own copy of the loops with the masks as constants
+struct BitRuleKernel {
+    struct LifeRule rule;
+    char const *name; // "Conway", "HighLife", ... or "generic"
+    bool specialised;
+    void (*rows)(struct LifeRule rule, struct BitGrid const *grid, struct BitGrid *newGrid, int begin, int end);
+    void (*tile_rows)(struct LifeRule rule, struct BitGrid const *grid, struct BitGrid *newGrid,
+                      struct TileTracker *tiles, int begin, int end);
+};
+
+struct BitRuleKernel SelectBitRuleKernel(struct LifeRule rule);
+// one indirect call per band, none per cell
+void IterateBitRuleRows(struct BitRuleKernel const *kernel, struct BitGrid const *grid, struct BitGrid *newGrid,
+                        int begin, int end);
+void IterateBitRuleTileRows(struct BitRuleKernel const *kernel, struct BitGrid const *grid, struct BitGrid *newGrid,
+                            struct TileTracker *tiles, int begin, int end);
+
+static inline int PopCount64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (int)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static inline int GetBitCell(struct BitGrid const *grid, int y, int x)
+{
+    return (int)(grid->cells[(long)y * grid->words + x / 64] >> (x % 64)) & 1;
+}
+
+#endif //GOL_BITLIFE_H
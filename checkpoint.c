@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "checkpoint.h"
+
+struct CheckpointWriter {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+
+    // owned by the thread while busy
+    bool busy;
+    bool stop;
+    char *path;
+    struct CheckpointHeader header;
+    void *payload;
+    size_t capacity;
+};
+
+struct CheckpointHeader MakeCheckpointHeader(enum CheckpointKind const kind, int64_t const height,
+                                             int64_t const width, uint64_t const raw_size)
+{
+    struct CheckpointHeader header = {
+        .magic = CHECKPOINT_MAGIC,
+        .version = CHECKPOINT_VERSION,
+        .kind = kind,
+        .height = height,
+        .width = width,
+        .raw_size = raw_size,
+    };
+    return header;
+}
+
+// whole words, the tail of the payload is read as if padded with zeros
+static inline uint64_t LoadWord(unsigned char const *bytes, size_t const size, size_t const word)
+{
+    uint64_t value = 0;
+    size_t const offset = word * 8;
+    memcpy(&value, bytes + offset, size - offset < 8 ? size - offset : 8);
+    return value;
+}
+
+static uint64_t Checksum(void const *payload, size_t const size)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < (size + 7) / 8; ++i)
+        hash = (hash ^ LoadWord(payload, size, i)) * 0x100000001B3ull;
+    return hash;
+}
+
+// records of (zero words, literal words) then the literals, NULL when it would not be smaller
+static void * CompressZeroRuns(void const *payload, size_t const size, size_t *stored)
+{
+    size_t const words = (size + 7) / 8;
+    // worst case is worse than raw, stop as soon as raw is reached
+    uint64_t *out = malloc(words * sizeof *out + 16);
+    if (out == nullptr)
+        return nullptr;
+
+    size_t k = 0;
+    for (size_t i = 0; i < words;) {
+        size_t zeros = 0, literals = 0;
+        while (i + zeros < words && zeros < UINT32_MAX && LoadWord(payload, size, i + zeros) == 0)
+            zeros++;
+        i += zeros;
+        while (i + literals < words && literals < UINT32_MAX && LoadWord(payload, size, i + literals) != 0)
+            literals++;
+
+        if (k + 1 + literals > words) {
+            free(out);
+            return nullptr;
+        }
+        out[k++] = zeros | (uint64_t)literals << 32;
+        for (size_t j = 0; j < literals; ++j)
+            out[k++] = LoadWord(payload, size, i + j);
+        i += literals;
+    }
+
+    *stored = k * sizeof *out;
+    return out;
+}
+
+static bool ExpandZeroRuns(uint64_t const *stored, size_t const stored_size, void *payload, size_t const size)
+{
+    size_t const words = (size + 7) / 8;
+    size_t const records = stored_size / 8;
+    uint64_t *out = payload;
+
+    size_t i = 0;
+    for (size_t k = 0; k < records;) {
+        size_t const zeros = (uint32_t)stored[k], literals = stored[k] >> 32;
+        k++;
+        if (i + zeros + literals > words || k + literals > records)
+            return false;
+        memset(out + i, 0, zeros * sizeof *out);
+        i += zeros;
+        memcpy(out + i, stored + k, literals * sizeof *out);
+        i += literals;
+        k += literals;
+    }
+    memset(out + i, 0, (words - i) * sizeof *out);
+
+    return true;
+}
+
+bool WriteCheckpoint(char const *path, struct CheckpointHeader const *header, void const *payload)
+{
+    struct CheckpointHeader written = *header;
+    written.checksum = Checksum(payload, header->raw_size);
+
+    void const *stored = payload;
+    void *compressed = nullptr;
+    written.stored_size = header->raw_size;
+    if (header->compression == CHECKPOINT_ZERO_RUNS) {
+        size_t size;
+        compressed = CompressZeroRuns(payload, header->raw_size, &size);
+        if (compressed != nullptr) {
+            stored = compressed;
+            written.stored_size = size;
+        } else {
+            written.compression = CHECKPOINT_RAW;
+        }
+    }
+
+    // a crash while writing leaves the previous checkpoint in place
+    size_t const length = strlen(path);
+    char *temporary = malloc(length + 5);
+    if (temporary == nullptr) {
+        free(compressed);
+        return false;
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", 5);
+
+    bool ok = false;
+    FILE *file = fopen(temporary, "wb");
+    if (file != nullptr) {
+        static char const padding[CHECKPOINT_PAYLOAD_OFFSET];
+        ok = fwrite(&written, sizeof written, 1, file) == 1
+             && fwrite(padding, CHECKPOINT_PAYLOAD_OFFSET - sizeof written, 1, file) == 1
+             && (written.stored_size == 0 || fwrite(stored, written.stored_size, 1, file) == 1)
+             && fflush(file) == 0;
+#ifndef _WIN32
+        ok = ok && fsync(fileno(file)) == 0;
+#endif
+        ok = fclose(file) == 0 && ok;
+    }
+
+    if (ok) {
+#ifdef _WIN32
+        remove(path);
+#endif
+        ok = rename(temporary, path) == 0;
+    }
+    if (!ok)
+        remove(temporary);
+
+    free(temporary);
+    free(compressed);
+    return ok;
+}
+
+static void * WriterLoop(void *argument)
+{
+    struct CheckpointWriter *writer = argument;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->busy && !writer->stop)
+            pthread_cond_wait(&writer->wake, &writer->lock);
+        if (!writer->busy)
+            break;
+        pthread_mutex_unlock(&writer->lock);
+
+        if (!WriteCheckpoint(writer->path, &writer->header, writer->payload))
+            fprintf(stderr, "fail to write the checkpoint %s\n", writer->path);
+
+        pthread_mutex_lock(&writer->lock);
+        writer->busy = false;
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return nullptr;
+}
+
+struct CheckpointWriter * CreateCheckpointWriter(void)
+{
+    struct CheckpointWriter *writer = calloc(1, sizeof *writer);
+    if (writer == nullptr)
+        return nullptr;
+
+    pthread_mutex_init(&writer->lock, nullptr);
+    pthread_cond_init(&writer->wake, nullptr);
+    if (pthread_create(&writer->thread, nullptr, WriterLoop, writer) != 0) {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->wake);
+        free(writer);
+        return nullptr;
+    }
+
+    return writer;
+}
+
+void FreeCheckpointWriter(struct CheckpointWriter *writer)
+{
+    if (writer == nullptr)
+        return;
+
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, nullptr);
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->wake);
+    free(writer->path);
+    free(writer->payload);
+    free(writer);
+}
+
+bool QueueCheckpoint(struct CheckpointWriter *writer, char const *path,
+                     struct CheckpointHeader const *header, void const *payload)
+{
+    pthread_mutex_lock(&writer->lock);
+    if (writer->busy) {
+        pthread_mutex_unlock(&writer->lock);
+        return false;
+    }
+
+    // the thread is idle, its buffers can be refilled
+    if (writer->capacity < header->raw_size) {
+        void *grown = realloc(writer->payload, header->raw_size);
+        if (grown == nullptr) {
+            pthread_mutex_unlock(&writer->lock);
+            return false;
+        }
+        writer->payload = grown;
+        writer->capacity = header->raw_size;
+    }
+    size_t const length = strlen(path) + 1;
+    char *copy = realloc(writer->path, length);
+    if (copy == nullptr) {
+        pthread_mutex_unlock(&writer->lock);
+        return false;
+    }
+    writer->path = memcpy(copy, path, length);
+    memcpy(writer->payload, payload, header->raw_size);
+    writer->header = *header;
+
+    writer->busy = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+
+    return true;
+}
+
+bool OpenCheckpoint(char const *path, struct Checkpoint *checkpoint)
+{
+    *checkpoint = (struct Checkpoint){0};
+
+    if (!MapFile(path, true, &checkpoint->file))
+        return false;
+
+    struct MappedFile const *file = &checkpoint->file;
+    struct CheckpointHeader *header = &checkpoint->header;
+    if (file->size < CHECKPOINT_PAYLOAD_OFFSET) {
+        CloseCheckpoint(checkpoint);
+        return false;
+    }
+    memcpy(header, file->data, sizeof *header);
+
+    if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof CHECKPOINT_MAGIC) != 0
+        || header->version != CHECKPOINT_VERSION
+        || header->stored_size > file->size - CHECKPOINT_PAYLOAD_OFFSET) {
+        CloseCheckpoint(checkpoint);
+        return false;
+    }
+
+    void const *stored = file->data + CHECKPOINT_PAYLOAD_OFFSET;
+    if (header->compression == CHECKPOINT_RAW && header->stored_size == header->raw_size) {
+        checkpoint->payload = stored;
+    } else if (header->compression == CHECKPOINT_ZERO_RUNS) {
+        checkpoint->decoded = malloc((header->raw_size + 7) / 8 * 8);
+        if (checkpoint->decoded == nullptr
+            || !ExpandZeroRuns(stored, header->stored_size, checkpoint->decoded, header->raw_size)) {
+            CloseCheckpoint(checkpoint);
+            return false;
+        }
+        checkpoint->payload = checkpoint->decoded;
+    } else {
+        CloseCheckpoint(checkpoint);
+        return false;
+    }
+
+    if (Checksum(checkpoint->payload, header->raw_size) != header->checksum) {
+        CloseCheckpoint(checkpoint);
+        return false;
+    }
+
+    return true;
+}
+
+void CloseCheckpoint(struct Checkpoint *checkpoint)
+{
+    UnmapFile(&checkpoint->file);
+    free(checkpoint->decoded);
+    *checkpoint = (struct Checkpoint){0};
+}
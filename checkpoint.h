@@ -0,0 +1,80 @@
+//
+// Checkpoints : a fixed header and the raw state of one engine, written in the background, read back by mmap.
+//
+
+#ifndef GOL_CHECKPOINT_H
+#define GOL_CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mapfile.h"
+
+#define CHECKPOINT_MAGIC "GOLCKPT"
+#define CHECKPOINT_VERSION 1
+// the payload starts on a page so an uncompressed one can be used straight from the mapping
+#define CHECKPOINT_PAYLOAD_OFFSET 4096
+
+// what the payload holds
+enum CheckpointKind {
+    CHECKPOINT_BITS = 1, // BitGrid words, height * ((width + 63) / 64) uint64
+    CHECKPOINT_CONWAY_FLOAT, // float[height][width][2], value + heat
+    CHECKPOINT_LENIA, // float[height][width]
+    CHECKPOINT_RAFLER, // float[height][width], the current field
+};
+
+enum CheckpointCompression {
+    CHECKPOINT_RAW,
+    CHECKPOINT_ZERO_RUNS, // runs of zero words and of literal words, for mostly empty grids
+};
+
+// written as is, little endian hosts only
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind; // enum CheckpointKind
+    uint32_t engine; // the launcher's own engine enum, for a resume with the same kernels
+    uint16_t birth; // LifeRule, 0 for the continuous engines
+    uint16_t survival;
+    int64_t height;
+    int64_t width;
+    uint64_t generation;
+    uint64_t rng_seed;
+    uint64_t rng_counter;
+    uint32_t compression; // enum CheckpointCompression
+    uint32_t reserved;
+    uint64_t raw_size; // payload once decoded
+    uint64_t stored_size; // payload in the file
+    uint64_t checksum; // of the decoded payload
+};
+
+struct CheckpointWriter;
+
+// a thread that compresses and writes while the caller keeps stepping
+struct CheckpointWriter * CreateCheckpointWriter(void);
+// waits for the checkpoint being written
+void FreeCheckpointWriter(struct CheckpointWriter *writer);
+
+// copies the payload and returns at once, false without waiting when the previous one is still being written
+bool QueueCheckpoint(struct CheckpointWriter *writer, char const *path,
+                     struct CheckpointHeader const *header, void const *payload);
+
+// the same on the calling thread, the file is replaced only once complete
+bool WriteCheckpoint(char const *path, struct CheckpointHeader const *header, void const *payload);
+
+struct Checkpoint {
+    struct CheckpointHeader header;
+    void const *payload; // header.raw_size bytes, inside the mapping when it was stored raw
+    struct MappedFile file;
+    void *decoded;
+};
+
+// checks the header and the checksum
+bool OpenCheckpoint(char const *path, struct Checkpoint *checkpoint);
+void CloseCheckpoint(struct Checkpoint *checkpoint);
+
+// a header for kind with magic and version filled in
+struct CheckpointHeader MakeCheckpointHeader(enum CheckpointKind kind, int64_t height, int64_t width, uint64_t raw_size);
+
+#endif //GOL_CHECKPOINT_H
@@ -0,0 +1,444 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "chunklife.h"
+#include "lifeword.h"
+
+// bit i of row r is the cell (64 * x + i, 64 * y + r)
+struct Chunk {
+    int32_t x, y;
+    uint64_t cells[2][CHUNK_SIZE]; // world->parity is the current generation
+    uint64_t population; // of the generation the last step wrote
+    struct Chunk *next_free;
+};
+
+// a chunk and its 8 neighbours, nw n ne w e sw s se, missing ones are empty
+struct ChunkStep {
+    struct Chunk *chunk;
+    struct Chunk const *around[8];
+};
+
+struct ChunkWorld {
+    struct LifeRule rule;
+
+    struct Chunk **chunks;
+    size_t count;
+    size_t capacity;
+
+    uint32_t *index; // open addressing, position in chunks + 1, 0 is an empty slot
+    size_t index_mask;
+
+    struct Chunk *free_chunks; // emptied chunks kept for the next allocation, no more of them than live ones
+    size_t free_count;
+
+    struct ChunkStep *steps;
+    size_t steps_capacity;
+
+    int parity;
+    uint64_t generation;
+};
+
+static uint64_t const empty_rows[CHUNK_SIZE];
+
+static inline int64_t ChunkOf(int64_t const cell)
+{
+    return cell >= 0 ? cell / CHUNK_SIZE : -((-cell + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+static inline size_t HashChunk(int32_t const x, int32_t const y)
+{
+    uint64_t h = ((uint64_t)(uint32_t)x << 32 | (uint32_t)y) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(h ^ h >> 29);
+}
+
+static struct Chunk * FindChunk(struct ChunkWorld const *world, int32_t const x, int32_t const y)
+{
+    for (size_t slot = HashChunk(x, y) & world->index_mask;; slot = (slot + 1) & world->index_mask) {
+        uint32_t const position = world->index[slot];
+        if (position == 0)
+            return nullptr;
+        struct Chunk *chunk = world->chunks[position - 1];
+        if (chunk->x == x && chunk->y == y)
+            return chunk;
+    }
+}
+
+static void IndexChunk(struct ChunkWorld *world, size_t const position)
+{
+    struct Chunk const *chunk = world->chunks[position];
+    size_t slot = HashChunk(chunk->x, chunk->y) & world->index_mask;
+    while (world->index[slot] != 0)
+        slot = (slot + 1) & world->index_mask;
+    world->index[slot] = (uint32_t)position + 1;
+}
+
+static void RebuildIndex(struct ChunkWorld *world, size_t const slots)
+{
+    if (slots != world->index_mask + 1) {
+        free(world->index);
+        world->index = malloc(slots * sizeof *world->index);
+        if (world->index == nullptr) {
+            fprintf(stderr, "fail to allocate %zu chunk slots\n", slots);
+            exit(EXIT_FAILURE);
+        }
+        world->index_mask = slots - 1;
+    }
+    memset(world->index, 0, slots * sizeof *world->index);
+
+    for (size_t i = 0; i < world->count; ++i)
+        IndexChunk(world, i);
+}
+
+static struct Chunk * InsertChunk(struct ChunkWorld *world, int32_t const x, int32_t const y)
+{
+    struct Chunk *chunk = world->free_chunks;
+    if (chunk != nullptr) {
+        world->free_chunks = chunk->next_free;
+        world->free_count--;
+    } else {
+        chunk = malloc(sizeof *chunk);
+        if (chunk == nullptr) {
+            fprintf(stderr, "fail to allocate a chunk\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memset(chunk, 0, sizeof *chunk);
+    chunk->x = x;
+    chunk->y = y;
+
+    if (world->count == world->capacity) {
+        world->capacity = world->capacity ? world->capacity * 2 : 64;
+        world->chunks = realloc(world->chunks, world->capacity * sizeof *world->chunks);
+        if (world->chunks == nullptr) {
+            fprintf(stderr, "fail to grow the chunk list to %zu\n", world->capacity);
+            exit(EXIT_FAILURE);
+        }
+    }
+    world->chunks[world->count++] = chunk;
+
+    // at most half full
+    if (2 * world->count > world->index_mask + 1)
+        RebuildIndex(world, 2 * (world->index_mask + 1));
+    else
+        IndexChunk(world, world->count - 1);
+
+    return chunk;
+}
+
+// memory follows the live region : the spare chunks are capped at the live ones,
+// the list and the index shrink once they are a quarter full or less
+static void ShrinkChunkWorld(struct ChunkWorld *world)
+{
+    while (world->free_count > world->count) {
+        struct Chunk *next = world->free_chunks->next_free;
+        free(world->free_chunks);
+        world->free_chunks = next;
+        world->free_count--;
+    }
+
+    size_t capacity = world->capacity;
+    while (capacity > 64 && 4 * world->count <= capacity)
+        capacity /= 2;
+    if (capacity != world->capacity) {
+        struct Chunk **chunks = realloc(world->chunks, capacity * sizeof *world->chunks);
+        if (chunks != nullptr) {
+            world->chunks = chunks;
+            world->capacity = capacity;
+        }
+        // sized again on the next step
+        free(world->steps);
+        world->steps = nullptr;
+        world->steps_capacity = 0;
+    }
+
+    size_t slots = world->index_mask + 1;
+    if (4 * world->count <= slots)
+        while (slots > 256 && 2 * world->count <= slots / 2)
+            slots /= 2;
+    RebuildIndex(world, slots);
+}
+
+static struct Chunk * GetOrInsertChunk(struct ChunkWorld *world, int32_t const x, int32_t const y)
+{
+    struct Chunk *chunk = FindChunk(world, x, y);
+    return chunk != nullptr ? chunk : InsertChunk(world, x, y);
+}
+
+struct ChunkWorld * CreateChunkWorld(struct LifeRule const rule)
+{
+    if (rule.birth & 1)
+        return nullptr;
+
+    struct ChunkWorld *world = calloc(1, sizeof *world);
+    if (world == nullptr)
+        return nullptr;
+    world->rule = rule;
+
+    world->index = calloc(256, sizeof *world->index);
+    if (world->index == nullptr) {
+        free(world);
+        return nullptr;
+    }
+    world->index_mask = 255;
+
+    return world;
+}
+
+void FreeChunkWorld(struct ChunkWorld *world)
+{
+    if (world == nullptr)
+        return;
+
+    for (size_t i = 0; i < world->count; ++i)
+        free(world->chunks[i]);
+    while (world->free_chunks != nullptr) {
+        struct Chunk *next = world->free_chunks->next_free;
+        free(world->free_chunks);
+        world->free_chunks = next;
+    }
+    free(world->chunks);
+    free(world->index);
+    free(world->steps);
+    free(world);
+}
+
+void LoadChunkWorldBits(struct ChunkWorld *world, struct BitGrid const *grid, int64_t const x, int64_t const y)
+{
+    for (int row = 0; row < grid->height; ++row) {
+        int64_t const cy = ChunkOf(y + row);
+        int const r = (int)(y + row - cy * CHUNK_SIZE);
+
+        for (int j = 0; j < grid->words; ++j) {
+            uint64_t const word = grid->cells[(long)row * grid->words + j];
+            if (word == 0)
+                continue;
+
+            // the word straddles two chunks unless x is a multiple of 64
+            int64_t const cx = ChunkOf(x + 64 * j);
+            int const shift = (int)(x + 64 * j - cx * CHUNK_SIZE);
+            GetOrInsertChunk(world, (int32_t)cx, (int32_t)cy)->cells[world->parity][r] |= word << shift;
+            if (shift != 0 && word >> (64 - shift) != 0)
+                GetOrInsertChunk(world, (int32_t)cx + 1, (int32_t)cy)->cells[world->parity][r] |= word >> (64 - shift);
+        }
+    }
+}
+
+void SetChunkCell(struct ChunkWorld *world, int64_t const x, int64_t const y, bool const alive)
+{
+    int64_t const cx = ChunkOf(x), cy = ChunkOf(y);
+    struct Chunk *chunk = alive ? GetOrInsertChunk(world, (int32_t)cx, (int32_t)cy)
+                                : FindChunk(world, (int32_t)cx, (int32_t)cy);
+    if (chunk == nullptr)
+        return;
+
+    uint64_t const bit = 1ull << (x - cx * CHUNK_SIZE);
+    uint64_t *row = &chunk->cells[world->parity][y - cy * CHUNK_SIZE];
+    *row = alive ? *row | bit : *row & ~bit;
+}
+
+void SetChunkRun(struct ChunkWorld *world, int64_t x, int64_t const y, int64_t length)
+{
+    int64_t const cy = ChunkOf(y);
+    int const r = (int)(y - cy * CHUNK_SIZE);
+
+    while (length > 0) {
+        int64_t const cx = ChunkOf(x);
+        int const shift = (int)(x - cx * CHUNK_SIZE);
+        int const count = length < CHUNK_SIZE - shift ? (int)length : CHUNK_SIZE - shift;
+        uint64_t const bits = (count == 64 ? ~0ull : (1ull << count) - 1) << shift;
+
+        GetOrInsertChunk(world, (int32_t)cx, (int32_t)cy)->cells[world->parity][r] |= bits;
+        x += count;
+        length -= count;
+    }
+}
+
+bool GetChunkCell(struct ChunkWorld const *world, int64_t const x, int64_t const y)
+{
+    int64_t const cx = ChunkOf(x), cy = ChunkOf(y);
+    struct Chunk const *chunk = FindChunk(world, (int32_t)cx, (int32_t)cy);
+    return chunk != nullptr && chunk->cells[world->parity][y - cy * CHUNK_SIZE] >> (x - cx * CHUNK_SIZE) & 1;
+}
+
+static inline uint64_t const * ChunkRows(struct Chunk const *chunk, int const parity)
+{
+    return chunk != nullptr ? chunk->cells[parity] : empty_rows;
+}
+
+static void StepChunk(struct LifeRule const rule, int const parity, struct ChunkStep const *step)
+{
+    struct Chunk const *const *around = step->around;
+    uint64_t const *rows = step->chunk->cells[parity];
+
+    // rows -1 to 64 of the chunk and of its west and east neighbours
+    uint64_t centre[CHUNK_SIZE + 2], west[CHUNK_SIZE + 2], east[CHUNK_SIZE + 2];
+    centre[0] = ChunkRows(around[1], parity)[CHUNK_SIZE - 1];
+    west[0] = ChunkRows(around[0], parity)[CHUNK_SIZE - 1];
+    east[0] = ChunkRows(around[2], parity)[CHUNK_SIZE - 1];
+    memcpy(centre + 1, rows, sizeof(uint64_t[CHUNK_SIZE]));
+    memcpy(west + 1, ChunkRows(around[3], parity), sizeof(uint64_t[CHUNK_SIZE]));
+    memcpy(east + 1, ChunkRows(around[4], parity), sizeof(uint64_t[CHUNK_SIZE]));
+    centre[CHUNK_SIZE + 1] = ChunkRows(around[6], parity)[0];
+    west[CHUNK_SIZE + 1] = ChunkRows(around[5], parity)[0];
+    east[CHUNK_SIZE + 1] = ChunkRows(around[7], parity)[0];
+
+    uint64_t *next = step->chunk->cells[parity ^ 1];
+    uint64_t population = 0;
+    for (int r = 1; r <= CHUNK_SIZE; ++r) {
+        uint64_t const word = LifeWord(rule.birth, rule.survival,
+                centre[r - 1] << 1 | west[r - 1] >> 63, centre[r - 1], centre[r - 1] >> 1 | east[r - 1] << 63,
+                centre[r] << 1 | west[r] >> 63, centre[r], centre[r] >> 1 | east[r] << 63,
+                centre[r + 1] << 1 | west[r + 1] >> 63, centre[r + 1], centre[r + 1] >> 1 | east[r + 1] << 63);
+        next[r - 1] = word;
+        population += PopCount64(word);
+    }
+    step->chunk->population = population;
+}
+
+static void StepChunks(void *context, int const begin, int const end)
+{
+    struct ChunkWorld const *world = context;
+    for (int i = begin; i < end; ++i)
+        StepChunk(world->rule, world->parity, &world->steps[i]);
+}
+
+void StepChunkWorld(struct ChunkWorld *world, struct WorkerPool *pool)
+{
+    int const parity = world->parity;
+
+    // births can only reach a missing chunk from a living cell on the border facing it
+    size_t const existing = world->count;
+    for (size_t i = 0; i < existing; ++i) {
+        struct Chunk const *chunk = world->chunks[i];
+        int32_t const x = chunk->x, y = chunk->y;
+        uint64_t const *rows = chunk->cells[parity];
+        uint64_t const top = rows[0], bottom = rows[CHUNK_SIZE - 1];
+        uint64_t sides = 0;
+        for (int r = 0; r < CHUNK_SIZE; ++r)
+            sides |= rows[r] & (1ull | 1ull << 63);
+
+        if (top)
+            GetOrInsertChunk(world, x, y - 1);
+        if (bottom)
+            GetOrInsertChunk(world, x, y + 1);
+        if (sides & 1)
+            GetOrInsertChunk(world, x - 1, y);
+        if (sides >> 63)
+            GetOrInsertChunk(world, x + 1, y);
+        if (top & 1)
+            GetOrInsertChunk(world, x - 1, y - 1);
+        if (top >> 63)
+            GetOrInsertChunk(world, x + 1, y - 1);
+        if (bottom & 1)
+            GetOrInsertChunk(world, x - 1, y + 1);
+        if (bottom >> 63)
+            GetOrInsertChunk(world, x + 1, y + 1);
+    }
+
+    if (world->steps_capacity < world->count) {
+        world->steps_capacity = world->capacity;
+        free(world->steps);
+        world->steps = malloc(world->steps_capacity * sizeof *world->steps);
+        if (world->steps == nullptr) {
+            fprintf(stderr, "fail to allocate %zu chunk steps\n", world->steps_capacity);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (size_t i = 0; i < world->count; ++i) {
+        struct Chunk *chunk = world->chunks[i];
+        struct ChunkStep *step = &world->steps[i];
+        step->chunk = chunk;
+        for (int k = 0, dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx)
+                if (dx || dy)
+                    step->around[k++] = FindChunk(world, chunk->x + dx, chunk->y + dy);
+    }
+
+    if (pool != nullptr)
+        RunBands(pool, (int)world->count, StepChunks, world);
+    else
+        StepChunks(world, 0, (int)world->count);
+
+    world->parity ^= 1;
+    world->generation++;
+
+    // chunks that went empty are given back, a neighbour brings them back when it needs them
+    size_t kept = 0;
+    for (size_t i = 0; i < world->count; ++i) {
+        struct Chunk *chunk = world->chunks[i];
+        if (chunk->population != 0) {
+            world->chunks[kept++] = chunk;
+        } else {
+            chunk->next_free = world->free_chunks;
+            world->free_chunks = chunk;
+            world->free_count++;
+        }
+    }
+    if (kept != world->count) {
+        world->count = kept;
+        ShrinkChunkWorld(world);
+    }
+}
+
+void ExtractChunkWorld(struct ChunkWorld const *world, int64_t const x, int64_t const y, struct BitGrid *out)
+{
+    uint64_t const last_mask = out->width % 64 ? ~0ull >> (64 - out->width % 64) : ~0ull;
+
+    for (int row = 0; row < out->height; ++row) {
+        int64_t const cy = ChunkOf(y + row);
+        int const r = (int)(y + row - cy * CHUNK_SIZE);
+
+        for (int j = 0; j < out->words; ++j) {
+            int64_t const cx = ChunkOf(x + 64 * j);
+            int const shift = (int)(x + 64 * j - cx * CHUNK_SIZE);
+
+            uint64_t word = ChunkRows(FindChunk(world, (int32_t)cx, (int32_t)cy), world->parity)[r] >> shift;
+            if (shift != 0)
+                word |= ChunkRows(FindChunk(world, (int32_t)cx + 1, (int32_t)cy), world->parity)[r] << (64 - shift);
+            out->cells[(long)row * out->words + j] = j == out->words - 1 ? word & last_mask : word;
+        }
+    }
+}
+
+bool ChunkWorldBounds(struct ChunkWorld const *world, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1)
+{
+    if (world->count == 0)
+        return false;
+
+    int32_t min_x = INT32_MAX, min_y = INT32_MAX, max_x = INT32_MIN, max_y = INT32_MIN;
+    for (size_t i = 0; i < world->count; ++i) {
+        struct Chunk const *chunk = world->chunks[i];
+        min_x = chunk->x < min_x ? chunk->x : min_x;
+        min_y = chunk->y < min_y ? chunk->y : min_y;
+        max_x = chunk->x > max_x ? chunk->x : max_x;
+        max_y = chunk->y > max_y ? chunk->y : max_y;
+    }
+    *x0 = (int64_t)min_x * CHUNK_SIZE;
+    *y0 = (int64_t)min_y * CHUNK_SIZE;
+    *x1 = ((int64_t)max_x + 1) * CHUNK_SIZE;
+    *y1 = ((int64_t)max_y + 1) * CHUNK_SIZE;
+
+    return true;
+}
+
+uint64_t ChunkWorldGeneration(struct ChunkWorld const *world)
+{
+    return world->generation;
+}
+
+uint64_t ChunkWorldPopulation(struct ChunkWorld const *world)
+{
+    uint64_t population = 0;
+    for (size_t i = 0; i < world->count; ++i) {
+        uint64_t const *rows = world->chunks[i]->cells[world->parity];
+        for (int r = 0; r < CHUNK_SIZE; ++r)
+            population += PopCount64(rows[r]);
+    }
+    return population;
+}
+
+size_t ChunkWorldChunkCount(struct ChunkWorld const *world)
+{
+    return world->count;
+}
@@ -0,0 +1,45 @@
+//
+// Unbounded Life made of 64x64 chunks in a hash map, memory and work follow the live region.
+//
+
+#ifndef GOL_CHUNKLIFE_H
+#define GOL_CHUNKLIFE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitlife.h"
+#include "liferule.h"
+#include "workers.h"
+
+// one chunk is CHUNK_SIZE rows of one word
+#define CHUNK_SIZE 64
+
+struct ChunkWorld;
+
+// nullptr for the B0 rules, which would fill the whole plane, or when out of memory
+struct ChunkWorld * CreateChunkWorld(struct LifeRule rule);
+void FreeChunkWorld(struct ChunkWorld *world);
+
+// the living cells of grid are set at [x, x + width) x [y, y + height), nothing wraps around
+void LoadChunkWorldBits(struct ChunkWorld *world, struct BitGrid const *grid, int64_t x, int64_t y);
+void SetChunkCell(struct ChunkWorld *world, int64_t x, int64_t y, bool alive);
+// makes [x, x + length) of row y alive, a word at a time
+void SetChunkRun(struct ChunkWorld *world, int64_t x, int64_t y, int64_t length);
+bool GetChunkCell(struct ChunkWorld const *world, int64_t x, int64_t y);
+
+// pool may be nullptr, chunks are split between its workers otherwise
+void StepChunkWorld(struct ChunkWorld *world, struct WorkerPool *pool);
+
+// copies the cells [x, x + out->width) x [y, y + out->height) of the plane into out
+void ExtractChunkWorld(struct ChunkWorld const *world, int64_t x, int64_t y, struct BitGrid *out);
+
+// smallest box holding every chunk, in cells, false when the world is empty
+bool ChunkWorldBounds(struct ChunkWorld const *world, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1);
+
+uint64_t ChunkWorldGeneration(struct ChunkWorld const *world);
+uint64_t ChunkWorldPopulation(struct ChunkWorld const *world);
+size_t ChunkWorldChunkCount(struct ChunkWorld const *world);
+
+#endif //GOL_CHUNKLIFE_H
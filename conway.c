@@ -0,0 +1,555 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "conway.h"
+#include "vectorized.h"
+#include "pattern.h"
+#include "rng.h"
+#include "lifeword.h"
+
+// the same soup as InitBitLife for the same seed, one draw per 64 cells unpacked
+void InitConwayRows(int const height, int const width, float (*pixelData)[height][width][2], uint64_t const seed,
+                    int const begin, int const end) {
+    for (int y = begin; y < end; ++y) {
+        for (int left = 0; left < width; left += 64) {
+            uint64_t const bits = RandomCellWord(seed, y, left);
+            int const count = width - left < 64 ? width - left : 64;
+            float (*cells)[2] = &(*pixelData)[y][left];
+            for (int i = 0; i < count; ++i) {
+                cells[i][0] = (float)(bits >> i & 1);
+                cells[i][1] = 1;
+            }
+        }
+    }
+}
+
+void InitConway(int const height, int const width, float (*pixelData)[height][width][2], uint64_t const seed) {
+    InitConwayRows(height, width, pixelData, seed, 0, height);
+}
+
+void LoadConwayBits(int const height, int const width, float (*pixelData)[height][width][2], struct BitGrid const *grid) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; x++) {
+            (*pixelData)[y][x][0] = (float)GetBitCell(grid, y, x);
+            (*pixelData)[y][x][1] = 1;
+        }
+    }
+}
+
+// one Life-like cell, a living cell cools down by 1% per generation;
+// birth and survival are constants in the specialised kernels
+RULE_INLINE void IterateFloatRuleRows(
+        uint16_t const birth, uint16_t const survival,
+        int const height, int const width, float const (*pixelColors)[height][width][2],
+        float (*newPixelColors)[height][width][2], int const begin, int const end) {
+    for (int y = begin; y < end; ++y) {
+        for (int x = 0; x < width; x++) {
+            float const moore = (*pixelColors)[(y + height -1)%height][(x+width-1)%width][0]
+            + (*pixelColors)[(y + height -1)%height][x][0]
+            + (*pixelColors)[(y + height -1)%height][(x+1)%width][0]
+
+            + (*pixelColors)[y][(x+width-1)%width][0]
+            + (*pixelColors)[y][(x+1)%width][0]
+
+            + (*pixelColors)[(y+1)%height][(x+width-1)%width][0]
+            + (*pixelColors)[(y+1)%height][x][0]
+            + (*pixelColors)[(y+1)%height][(x+1)%width][0];
+
+            bool const alive = (*pixelColors)[y][x][0] != 0;
+            float const heat = (*pixelColors)[y][x][1];
+            if (!LifeRuleNext((struct LifeRule){birth, survival}, alive, (int)moore)) {
+                (*newPixelColors)[y][x][0] = 0;
+                (*newPixelColors)[y][x][1] = 0;
+            } else {
+                (*newPixelColors)[y][x][0] = 1;
+                (*newPixelColors)[y][x][1] = alive ? heat * .99f : 1;
+            }
+        }
+    }
+}
+
+typedef void (*FloatRuleRows)(struct LifeRule rule, int height, int width, void const *pixelColors,
+                              void *newPixelColors, int begin, int end);
+
+// one copy of the row loop per rule, like the bit kernels
+#define FLOAT_RULE_KERNEL(name, birth, survival) \
+    static void IterateFloatRows_##name(struct LifeRule const rule, int const height, int const width, \
+                                        void const *pixelColors, void *newPixelColors, \
+                                        int const begin, int const end) \
+    { \
+        (void)rule; \
+        IterateFloatRuleRows(birth, survival, height, width, pixelColors, newPixelColors, begin, end); \
+    }
+
+SPECIALISED_RULES(FLOAT_RULE_KERNEL)
+
+// masks read at run time for the rules without their own copy
+static void IterateFloatRows_Generic(struct LifeRule const rule, int const height, int const width,
+                                     void const *pixelColors, void *newPixelColors, int const begin, int const end)
+{
+    IterateFloatRuleRows(rule.birth, rule.survival, height, width, pixelColors, newPixelColors, begin, end);
+}
+
+#define FLOAT_RULE_ENTRY(name, birth, survival) {{birth, survival}, IterateFloatRows_##name},
+
+static struct {
+    struct LifeRule rule;
+    FloatRuleRows rows;
+} const float_kernels[] = {
+    SPECIALISED_RULES(FLOAT_RULE_ENTRY)
+};
+
+void IterateConwayRows(
+        int const height, int const width, float (*pixelColors)[height][width][2],
+        float (*newPixelColors)[height][width][2], struct LifeRule const rule,
+        int const begin, int const end) {
+    // one lookup per band, none per cell
+    FloatRuleRows rows = IterateFloatRows_Generic;
+    for (size_t i = 0; i < sizeof float_kernels / sizeof *float_kernels; ++i)
+        if (float_kernels[i].rule.birth == rule.birth && float_kernels[i].rule.survival == rule.survival)
+            rows = float_kernels[i].rows;
+
+    rows(rule, height, width, pixelColors, newPixelColors, begin, end);
+}
+
+void IterateConway(
+        int const height, int const width, float (*pixelColors)[height][width][2],
+        float (*newPixelColors)[height][width][2], struct LifeRule const rule) {
+    IterateConwayRows(height, width, pixelColors, newPixelColors, rule, 0, height);
+}
+
+// the board is the context, each worker steps its band of rows
+static void IterateConwayBand(void *context, int const begin, int const end)
+{
+    struct Conway *conway = context;
+    int const height = conway->settings.height, width = conway->settings.width;
+
+    switch (conway->engine) {
+    case CONWAY_HASHLIFE:
+    case CONWAY_CHUNKS:
+        break;
+    case CONWAY_LUT:
+        // bands of row pairs
+        IterateBitLifeLut4Pairs(conway->lut, &conway->grid, &conway->newGrid, begin, end);
+        break;
+    case CONWAY_BITS:
+        // bands of tile rows
+        IterateBitRuleTileRows(&conway->kernel, &conway->grid, &conway->newGrid, &conway->tiles, begin, end);
+        break;
+    case CONWAY_FLOAT_SIMD:
+        IterateConwayVectorizedRows(height, width, conway->pixelData, conway->newPixelData, begin, end);
+        break;
+    case CONWAY_FLOAT:
+        IterateConwayRows(height, width, conway->pixelData, conway->newPixelData, conway->rule, begin, end);
+        break;
+    }
+}
+
+struct SoupBand {
+    struct BitGrid *grid; // nullptr : the float board
+    void *pixelData;
+    int height;
+    int width;
+    uint64_t seed;
+};
+
+static void InitSoupBand(void *context, int const begin, int const end)
+{
+    struct SoupBand const *band = context;
+    if (band->grid != nullptr)
+        InitBitLifeRows(band->grid, band->seed, begin, end);
+    else
+        InitConwayRows(band->height, band->width, band->pixelData, band->seed, begin, end);
+}
+
+static void const * CheckpointPayload(struct Conway const *conway)
+{
+    return conway->pixelData != nullptr ? conway->pixelData : (void const *)conway->grid.cells;
+}
+
+// the bit engines share their layout, a checkpoint of one resumes in the other
+static void ResumeConway(struct Conway *conway, uint64_t const seed)
+{
+    struct ConwaySettings const *settings = &conway->settings;
+    bool const is_float = conway->pixelData != nullptr;
+    int const height = settings->height, width = settings->width;
+
+    conway->checkpoint_header = is_float
+        ? MakeCheckpointHeader(CHECKPOINT_CONWAY_FLOAT, height, width, sizeof(float[height][width][2]))
+        : MakeCheckpointHeader(CHECKPOINT_BITS, height, width,
+                               (size_t)conway->grid.height * conway->grid.words * sizeof *conway->grid.cells);
+    struct CheckpointHeader *header = &conway->checkpoint_header;
+    header->engine = conway->engine;
+    header->birth = conway->rule.birth;
+    header->survival = conway->rule.survival;
+    header->rng_seed = seed;
+    header->compression = is_float ? CHECKPOINT_RAW : CHECKPOINT_ZERO_RUNS;
+
+    struct Checkpoint resume;
+    if (OpenCheckpoint(settings->checkpoint_file, &resume)) {
+        struct CheckpointHeader const *saved = &resume.header;
+        if (saved->kind == header->kind && saved->height == height && saved->width == width
+            && saved->raw_size == header->raw_size
+            && saved->birth == header->birth && saved->survival == header->survival) {
+            memcpy(is_float ? conway->pixelData : (void *)conway->grid.cells, resume.payload, saved->raw_size);
+            conway->generation = saved->generation;
+            printf("resumed %s at generation %llu\n", settings->checkpoint_file,
+                   (unsigned long long)conway->generation);
+        } else {
+            printf("%s was saved for another board or rule, starting over\n", settings->checkpoint_file);
+        }
+        CloseCheckpoint(&resume);
+    }
+
+    if (settings->checkpoint_every != 0) {
+        conway->checkpoints = CreateCheckpointWriter();
+        if (conway->checkpoints == nullptr) {
+            fprintf(stderr, "fail to start the checkpoint writer\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void CreateConway(struct Conway *conway, enum ConwayEngine engine, struct ConwaySettings const *settings,
+                  uint64_t const seed, struct WorkerPool *pool)
+{
+    *conway = (struct Conway){.settings = *settings, .rule = settings->rule, .pool = pool};
+    int const height = settings->height, width = settings->width;
+
+    struct PatternFile pattern = {0};
+    struct PatternInfo pattern_info = {0};
+    if (settings->pattern_file != nullptr) {
+        if (!OpenPatternFile(settings->pattern_file, &pattern) || !ReadPatternInfo(&pattern, &pattern_info)) {
+            fprintf(stderr, "fail to read the pattern %s\n", settings->pattern_file);
+            exit(EXIT_FAILURE);
+        }
+        if (pattern_info.has_rule)
+            conway->rule = pattern_info.rule;
+    }
+    int64_t const pattern_x = (width - pattern_info.width) / 2, pattern_y = (height - pattern_info.height) / 2;
+    FormatLifeRule(conway->rule, conway->rule_text);
+
+    bool const is_conway = conway->rule.birth == CONWAY_LIFE_RULE.birth
+                           && conway->rule.survival == CONWAY_LIFE_RULE.survival;
+    if (engine == CONWAY_FLOAT_SIMD && !is_conway) {
+        printf("the SIMD kernels only know B3/S23, stepping %s on floats\n", conway->rule_text);
+        engine = CONWAY_FLOAT;
+    }
+    conway->engine = engine;
+    conway->kernel = SelectBitRuleKernel(conway->rule);
+
+    bool const is_bits = engine != CONWAY_FLOAT && engine != CONWAY_FLOAT_SIMD;
+    if (is_bits) {
+        conway->grid = CreateBitGrid(height, width);
+        conway->newGrid = CreateBitGrid(height, width);
+    } else {
+        conway->pixelData = malloc(sizeof(float[height][width][2]));
+        conway->newPixelData = malloc(sizeof(float[height][width][2]));
+    }
+
+    if ((is_bits && (conway->grid.cells == nullptr || conway->newGrid.cells == nullptr))
+        || (!is_bits && (conway->pixelData == nullptr || conway->newPixelData == nullptr))) {
+        fprintf(stderr, "fail to allocate the board\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pattern.data != nullptr) {
+        struct BitGrid loaded = is_bits ? conway->grid : CreateBitGrid(height, width);
+        if (loaded.cells == nullptr || !LoadPatternBits(&pattern, &loaded, pattern_x, pattern_y)) {
+            fprintf(stderr, "fail to decode the pattern %s\n", settings->pattern_file);
+            exit(EXIT_FAILURE);
+        }
+        if (!is_bits) {
+            LoadConwayBits(height, width, conway->pixelData, &loaded);
+            FreeBitGrid(&loaded);
+        }
+    } else {
+        // one band of rows per worker, the soup does not depend on how many there are
+        struct SoupBand band = {is_bits ? &conway->grid : nullptr, conway->pixelData, height, width, seed};
+        RunBands(pool, height, InitSoupBand, &band);
+    }
+
+    if (settings->checkpoint_file != nullptr) {
+        if (engine == CONWAY_HASHLIFE || engine == CONWAY_CHUNKS)
+            printf("no checkpoints for the unbounded engines\n");
+        else
+            ResumeConway(conway, seed);
+    }
+    conway->last_checkpoint = conway->generation;
+
+    if (engine == CONWAY_BITS) {
+        conway->tiles = CreateTileTracker(&conway->grid);
+        if (conway->tiles.changed == nullptr) {
+            fprintf(stderr, "fail to allocate the tile flags\n");
+            exit(EXIT_FAILURE);
+        }
+
+        conway->cycle = CreateCycleDetector(settings->cycle_history);
+        if (conway->cycle.hashes == nullptr) {
+            fprintf(stderr, "fail to allocate the cycle history\n");
+            exit(EXIT_FAILURE);
+        }
+        conway->grid_hash = HashBitGrid(&conway->grid);
+        ObserveGeneration(&conway->cycle, conway->generation, conway->grid_hash);
+    }
+
+    if (engine == CONWAY_FLOAT_SIMD)
+        printf("Conway kernel: %s\n", VectorKernelName());
+    if (!is_bits) {
+        conway->blocking = ChooseTemporalBlocking(height, width, settings->temporal_steps);
+        if (conway->blocking.generations > 1) {
+            printf("temporal blocking: %d generations per pass, tiles of %dx%d, %zu KiB of L2\n",
+                   conway->blocking.generations, conway->blocking.columns, conway->blocking.rows, CacheSize() / 1024);
+            if (!CreateTemporalScratch(&conway->scratch, conway->blocking, WorkerCount(pool))) {
+                fprintf(stderr, "fail to allocate the temporal tiles\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    if (engine == CONWAY_BITS)
+        printf("%s kernel: %s\n", conway->rule_text, conway->kernel.name);
+
+    if (settings->pyramid && is_bits) {
+        if (!CreateDensityPyramid(&conway->pyramid, height, width)) {
+            fprintf(stderr, "fail to allocate the density pyramid\n");
+            exit(EXIT_FAILURE);
+        }
+        if (engine == CONWAY_BITS)
+            UpdateDensityPyramid(&conway->pyramid, &conway->grid, nullptr);
+    }
+
+    if (engine == CONWAY_LUT) {
+        conway->lut = malloc(sizeof *conway->lut);
+        if (conway->lut == nullptr) {
+            fprintf(stderr, "fail to allocate the rule tables\n");
+            exit(EXIT_FAILURE);
+        }
+        BuildLifeLut(conway->lut, conway->rule);
+    }
+
+    if (engine == CONWAY_HASHLIFE) {
+        conway->life = CreateHashLife(settings->hashlife_memory);
+        if (conway->life == nullptr) {
+            fprintf(stderr, "fail to create the hashlife universe\n");
+            exit(EXIT_FAILURE);
+        }
+        if (!SetHashLifeRule(conway->life, conway->rule)) {
+            fprintf(stderr, "hashlife cannot step %s, B0 fills the plane\n", conway->rule_text);
+            exit(EXIT_FAILURE);
+        }
+        // a macrocell goes straight into the quadtree, even when it is far bigger than the board,
+        // and the board looks at it from where the other engines would have put it
+        if (pattern.format == PATTERN_MACROCELL) {
+            if (!LoadPatternHashLife(&pattern, conway->life)) {
+                fprintf(stderr, "fail to decode the pattern %s\n", settings->pattern_file);
+                exit(EXIT_FAILURE);
+            }
+            conway->life_x = -pattern_x;
+            conway->life_y = -pattern_y;
+        } else {
+            LoadHashLifeBits(conway->life, &conway->grid);
+        }
+    }
+
+    if (engine == CONWAY_CHUNKS) {
+        conway->world = CreateChunkWorld(conway->rule);
+        if (conway->world == nullptr) {
+            fprintf(stderr, "fail to create the chunk world for %s\n", conway->rule_text);
+            exit(EXIT_FAILURE);
+        }
+        if (pattern.data != nullptr)
+            LoadPatternChunks(&pattern, conway->world, pattern_x, pattern_y);
+        else
+            LoadChunkWorldBits(conway->world, &conway->grid, 0, 0);
+    }
+    ClosePatternFile(&pattern);
+}
+
+void FreeConway(struct Conway *conway)
+{
+    if (conway->checkpoints != nullptr) {
+        // the last generation, once the one in flight is on disk
+        FreeCheckpointWriter(conway->checkpoints);
+        conway->checkpoint_header.generation = conway->generation;
+        if (conway->generation != conway->last_checkpoint
+            && !WriteCheckpoint(conway->settings.checkpoint_file, &conway->checkpoint_header, CheckpointPayload(conway)))
+            fprintf(stderr, "fail to write the checkpoint %s\n", conway->settings.checkpoint_file);
+    }
+
+    free(conway->pixelData);
+    free(conway->newPixelData);
+    FreeBitGrid(&conway->grid);
+    FreeBitGrid(&conway->newGrid);
+    FreeHashLife(conway->life);
+    FreeChunkWorld(conway->world);
+    FreeTileTracker(&conway->tiles);
+    FreeDensityPyramid(&conway->pyramid);
+    FreeTemporalScratch(&conway->scratch);
+    free(conway->lut);
+    FreeCycleDetector(&conway->cycle);
+    *conway = (struct Conway){0};
+}
+
+static void QueueConwayCheckpoint(struct Conway *conway)
+{
+    if (conway->checkpoints != nullptr
+        && conway->generation - conway->last_checkpoint >= conway->settings.checkpoint_every) {
+        // copied on this thread, compressed and written on the writer's, skipped while it is still busy
+        conway->checkpoint_header.generation = conway->generation;
+        if (QueueCheckpoint(conway->checkpoints, conway->settings.checkpoint_file, &conway->checkpoint_header,
+                            CheckpointPayload(conway)))
+            conway->last_checkpoint = conway->generation;
+    }
+}
+
+void StepConway(struct Conway *conway)
+{
+    enum ConwayEngine const engine = conway->engine;
+    int const height = conway->settings.height;
+
+    if (conway->settled) {
+        // nothing left to compute
+    } else if (engine == CONWAY_HASHLIFE) {
+        AdvanceHashLife(conway->life, conway->settings.hashlife_step);
+        conway->generation = HashLifeGeneration(conway->life);
+    } else if (engine == CONWAY_CHUNKS) {
+        StepChunkWorld(conway->world, conway->pool);
+        conway->generation = ChunkWorldGeneration(conway->world);
+    } else {
+        int bands = height;
+        if (engine == CONWAY_BITS) {
+            PrepareTiles(&conway->tiles);
+            bands = conway->tiles.rows;
+        } else if (engine == CONWAY_LUT) {
+            bands = (height + 1) / 2;
+        }
+
+        RunBands(conway->pool, bands, IterateConwayBand, conway);
+        conway->generation++;
+
+        if (engine == CONWAY_BITS) {
+            conway->grid_hash += TileHashChange(&conway->tiles);
+            uint64_t const period = ObserveGeneration(&conway->cycle, conway->generation, conway->grid_hash);
+            if (period != 0) {
+                printf("period %llu from generation %llu, found at %llu\n", (unsigned long long)period,
+                       (unsigned long long)conway->cycle.start, (unsigned long long)conway->generation);
+                conway->settled = true;
+            }
+        }
+
+        // intervertit les buffers, les workers ont tous fini leur bande
+        void *tmp = conway->pixelData;
+        conway->pixelData = conway->newPixelData;
+        conway->newPixelData = tmp;
+
+        struct BitGrid const tmpGrid = conway->grid;
+        conway->grid = conway->newGrid;
+        conway->newGrid = tmpGrid;
+
+        // the blocks over the tiles that changed and nothing else
+        if (engine == CONWAY_BITS && conway->pyramid.levels != 0)
+            UpdateDensityPyramid(&conway->pyramid, &conway->grid, conway->tiles.next_changed);
+    }
+
+    uint64_t const target = conway->settings.cycle_target;
+    if (conway->settled && target > conway->generation) {
+        // the target looks like a generation less than one period away
+        struct CycleDetector const *cycle = &conway->cycle;
+        uint64_t const from = CycleEquivalent(cycle, conway->generation), to = CycleEquivalent(cycle, target);
+        uint64_t const steps = (to + cycle->period - from) % cycle->period;
+        for (uint64_t i = 0; i < steps; ++i) {
+            IterateBitRuleRows(&conway->kernel, &conway->grid, &conway->newGrid, 0, height);
+            struct BitGrid const next = conway->newGrid;
+            conway->newGrid = conway->grid;
+            conway->grid = next;
+        }
+        printf("fast forward to generation %llu\n", (unsigned long long)target);
+        conway->generation = target;
+        if (conway->pyramid.levels != 0)
+            UpdateDensityPyramid(&conway->pyramid, &conway->grid, nullptr);
+    }
+
+    QueueConwayCheckpoint(conway);
+}
+
+struct ConwayPass {
+    struct Conway *conway;
+    int generations;
+};
+
+static void IterateConwayPass(void *context, int const worker, int const begin, int const end)
+{
+    struct ConwayPass const *pass = context;
+    struct Conway *conway = pass->conway;
+    int const height = conway->settings.height, width = conway->settings.width;
+
+    IterateConwayBlocks(height, width, conway->pixelData, conway->newPixelData,
+                        conway->engine == CONWAY_FLOAT ? &conway->rule : nullptr,
+                        conway->blocking, pass->generations, &conway->scratch, worker, begin, end);
+}
+
+void AdvanceConway(struct Conway *conway, uint64_t steps)
+{
+    bool const blocked = (conway->engine == CONWAY_FLOAT || conway->engine == CONWAY_FLOAT_SIMD)
+                         && conway->blocking.generations > 1;
+
+    while (blocked && steps > 0) {
+        struct ConwayPass pass = {conway, conway->blocking.generations};
+        if ((uint64_t)pass.generations > steps)
+            pass.generations = (int)steps;
+
+        // one read and one write of the board for the whole pass
+        int const tiles = TemporalTiles(conway->settings.height, conway->settings.width, conway->blocking);
+        RunWorkerBands(conway->pool, tiles, IterateConwayPass, &pass);
+        void *tmp = conway->pixelData;
+        conway->pixelData = conway->newPixelData;
+        conway->newPixelData = tmp;
+
+        conway->generation += pass.generations;
+        steps -= pass.generations;
+        QueueConwayCheckpoint(conway);
+    }
+
+    for (; steps > 0 && !conway->settled; --steps)
+        StepConway(conway);
+}
+
+struct BitGrid const * ConwayBits(struct Conway *conway)
+{
+    if (conway->engine == CONWAY_HASHLIFE)
+        ExtractHashLife(conway->life, conway->life_x, conway->life_y, &conway->grid);
+    else if (conway->engine == CONWAY_CHUNKS)
+        ExtractChunkWorld(conway->world, 0, 0, &conway->grid);
+
+    return conway->grid.cells != nullptr ? &conway->grid : nullptr;
+}
+
+struct DensityPyramid const * ConwayPyramid(struct Conway *conway)
+{
+    if (conway->pyramid.levels == 0)
+        return nullptr;
+    if (conway->engine != CONWAY_BITS)
+        UpdateDensityPyramid(&conway->pyramid, ConwayBits(conway), nullptr);
+    return &conway->pyramid;
+}
+
+uint64_t ConwayPopulation(struct Conway *conway)
+{
+    if (conway->engine == CONWAY_HASHLIFE)
+        return HashLifePopulation(conway->life);
+    if (conway->engine == CONWAY_CHUNKS)
+        return ChunkWorldPopulation(conway->world);
+
+    if (conway->pixelData != nullptr) {
+        uint64_t population = 0;
+        int const height = conway->settings.height, width = conway->settings.width;
+        float const (*pixelData)[height][width][2] = conway->pixelData;
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                population += (*pixelData)[y][x][0] != 0;
+        return population;
+    }
+
+    return (uint64_t)CountBitLife(&conway->grid);
+}
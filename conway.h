@@ -0,0 +1,108 @@
+//
+// Life-like rules on a torus, stepped by one of several engines, with or without a window.
+//
+
+#ifndef GOL_CONWAY_H
+#define GOL_CONWAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitlife.h"
+#include "liferule.h"
+#include "lifelut.h"
+#include "hashlife.h"
+#include "chunklife.h"
+#include "cycle.h"
+#include "workers.h"
+#include "checkpoint.h"
+#include "temporal.h"
+#include "pyramid.h"
+
+enum ConwayEngine {
+    CONWAY_FLOAT, // float[h][w][2] value + heat, any rule
+    CONWAY_FLOAT_SIMD, // same layout, on AVX2/AVX-512 when the CPU has it, B3/S23 only
+    CONWAY_BITS, // 64 cells per word, no heat, skips the tiles that settled
+    CONWAY_LUT, // 64 cells per word, 2x2 blocks looked up from a table built for the rule
+    CONWAY_HASHLIFE, // quadtree on an unbounded plane, hashlife_step generations per step
+    CONWAY_CHUNKS, // 64x64 chunks in a hash map on an unbounded plane, the board shows [0, width) x [0, height)
+};
+
+struct ConwaySettings {
+    int height;
+    int width;
+    struct LifeRule rule;
+    char const *pattern_file; // RLE, macrocell or plaintext centred on the board instead of a soup, its rule wins
+    uint64_t hashlife_step;
+    size_t hashlife_memory;
+    int cycle_history; // longest period looked for, CONWAY_BITS only
+    uint64_t cycle_target; // once a cycle is found, jump to this generation and stop, 0 : stop where it is
+    char const *checkpoint_file; // resumed from when it matches the board, rewritten every checkpoint_every generations
+    uint64_t checkpoint_every; // 0 : resume only
+    int temporal_steps; // generations per pass of AdvanceConway on the float engines, 0 : from the L2 size
+    bool pyramid; // a DensityPyramid of the board for ConwayPyramid, the bit engines only
+};
+
+struct Conway {
+    enum ConwayEngine engine;
+    struct ConwaySettings settings;
+    struct LifeRule rule; // the settings' one or the pattern's
+    char rule_text[24];
+    struct BitRuleKernel kernel;
+
+    void *pixelData; // float[height][width][2], the float engines
+    void *newPixelData;
+    struct BitGrid grid; // the bit engines, ConwayBits fills it for the unbounded ones
+    struct BitGrid newGrid;
+    struct HashLife *life;
+    int64_t life_x, life_y; // the cell of the plane under the top left corner of the board
+    struct ChunkWorld *world;
+    struct TileTracker tiles;
+    struct LifeLut *lut;
+    struct CycleDetector cycle;
+    struct TemporalBlocking blocking; // the float engines
+    struct TemporalScratch scratch; // the tiles of each worker once blocking runs several generations
+    struct DensityPyramid pyramid; // levels 0 when not asked for
+    struct WorkerPool *pool; // borrowed
+
+    uint64_t generation;
+    uint64_t grid_hash;
+    bool settled; // a cycle was found, stepping does nothing more
+
+    struct CheckpointHeader checkpoint_header;
+    struct CheckpointWriter *checkpoints;
+    uint64_t last_checkpoint;
+};
+
+// loads the pattern or a soup of seed and resumes the checkpoint, exits when something cannot be set up
+void CreateConway(struct Conway *conway, enum ConwayEngine engine, struct ConwaySettings const *settings,
+                  uint64_t seed, struct WorkerPool *pool);
+// writes a last checkpoint when there are any
+void FreeConway(struct Conway *conway);
+
+// one generation, hashlife_step of them for hashlife
+void StepConway(struct Conway *conway);
+// as far as steps calls to StepConway, the float engines run blocking.generations of them per pass of the board;
+// stops early once the board settled
+void AdvanceConway(struct Conway *conway, uint64_t steps);
+
+// the board as bits, extracted from the plane for the unbounded engines, nullptr for the float ones
+struct BitGrid const * ConwayBits(struct Conway *conway);
+uint64_t ConwayPopulation(struct Conway *conway);
+// the pyramid of the current generation, grid holding its cells once it returns, nullptr when there is none;
+// CONWAY_BITS updates it on each step from the tiles that changed, the other bit engines rebuild it here
+struct DensityPyramid const * ConwayPyramid(struct Conway *conway);
+
+// the float kernels
+void InitConway(int height, int width, float (*pixelData)[height][width][2], uint64_t seed);
+// rows [begin, end) of it, bands of rows can run on different threads
+void InitConwayRows(int height, int width, float (*pixelData)[height][width][2], uint64_t seed, int begin, int end);
+void LoadConwayBits(int height, int width, float (*pixelData)[height][width][2], struct BitGrid const *grid);
+// a living cell cools down by 1% per generation, the rules of SPECIALISED_RULES have a loop of their own
+void IterateConwayRows(int height, int width, float (*pixelColors)[height][width][2],
+                       float (*newPixelColors)[height][width][2], struct LifeRule rule, int begin, int end);
+void IterateConway(int height, int width, float (*pixelColors)[height][width][2],
+                   float (*newPixelColors)[height][width][2], struct LifeRule rule);
+
+#endif //GOL_CONWAY_H
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycle.h"
+#include "rng.h"
+
+// generation UINT64_MAX marks an empty slot
+#define CYCLE_EMPTY UINT64_MAX
+
+struct CycleDetector CreateCycleDetector(int const slots)
+{
+    int size = 1;
+    while (size < slots)
+        size *= 2;
+
+    struct CycleDetector cycle = {.slots = size};
+    cycle.hashes = calloc(size, sizeof *cycle.hashes);
+    cycle.generations = calloc(size, sizeof *cycle.generations);
+    cycle.table_hashes = calloc(2 * (size_t)size, sizeof *cycle.table_hashes);
+    cycle.table_generations = calloc(2 * (size_t)size, sizeof *cycle.table_generations);
+    if (cycle.hashes == nullptr || cycle.generations == nullptr
+        || cycle.table_hashes == nullptr || cycle.table_generations == nullptr) {
+        FreeCycleDetector(&cycle);
+        return cycle;
+    }
+    ResetCycleDetector(&cycle);
+
+    return cycle;
+}
+
+void FreeCycleDetector(struct CycleDetector *cycle)
+{
+    free(cycle->hashes);
+    free(cycle->generations);
+    free(cycle->table_hashes);
+    free(cycle->table_generations);
+    cycle->hashes = nullptr;
+    cycle->generations = nullptr;
+    cycle->table_hashes = nullptr;
+    cycle->table_generations = nullptr;
+}
+
+void ResetCycleDetector(struct CycleDetector *cycle)
+{
+    memset(cycle->generations, 0xff, cycle->slots * sizeof *cycle->generations);
+    memset(cycle->table_generations, 0xff, 2 * (size_t)cycle->slots * sizeof *cycle->table_generations);
+    cycle->period = cycle->start = 0;
+}
+
+static size_t HomeSlot(struct CycleDetector const *cycle, uint64_t const hash)
+{
+    return (size_t)RandomMix(hash) & (2 * (size_t)cycle->slots - 1);
+}
+
+// the slot holding hash, or the empty one where it would go
+static size_t FindHash(struct CycleDetector const *cycle, uint64_t const hash)
+{
+    size_t const mask = 2 * (size_t)cycle->slots - 1;
+    size_t i = HomeSlot(cycle, hash);
+    while (cycle->table_generations[i] != CYCLE_EMPTY && cycle->table_hashes[i] != hash)
+        i = (i + 1) & mask;
+    return i;
+}
+
+// backward shift, the entries after the hole that may sit in it move up so the probes still find them
+static void RemoveSlot(struct CycleDetector *cycle, size_t i)
+{
+    size_t const mask = 2 * (size_t)cycle->slots - 1;
+    for (size_t j = (i + 1) & mask; cycle->table_generations[j] != CYCLE_EMPTY; j = (j + 1) & mask) {
+        size_t const home = HomeSlot(cycle, cycle->table_hashes[j]);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            cycle->table_hashes[i] = cycle->table_hashes[j];
+            cycle->table_generations[i] = cycle->table_generations[j];
+            i = j;
+        }
+    }
+    cycle->table_generations[i] = CYCLE_EMPTY;
+}
+
+uint64_t ObserveGeneration(struct CycleDetector *cycle, uint64_t const generation, uint64_t const hash)
+{
+    if (cycle->period)
+        return cycle->period;
+
+    // the full 64 bit hash again within the window, the earlier generation starts the cycle
+    size_t slot = FindHash(cycle, hash);
+    uint64_t const seen = cycle->table_generations[slot];
+    if (seen != CYCLE_EMPTY && seen < generation) {
+        cycle->period = generation - seen;
+        cycle->start = seen;
+        return cycle->period;
+    }
+
+    // the generation that leaves the window, unless a later one took its hash over
+    size_t const at = generation & (cycle->slots - 1);
+    if (cycle->generations[at] != CYCLE_EMPTY) {
+        size_t const old = FindHash(cycle, cycle->hashes[at]);
+        if (cycle->table_generations[old] == cycle->generations[at])
+            RemoveSlot(cycle, old);
+    }
+    cycle->hashes[at] = hash;
+    cycle->generations[at] = generation;
+
+    slot = FindHash(cycle, hash);
+    cycle->table_hashes[slot] = hash;
+    cycle->table_generations[slot] = generation;
+
+    return 0;
+}
+
+uint64_t CycleEquivalent(struct CycleDetector const *cycle, uint64_t const generation)
+{
+    if (cycle->period == 0 || generation < cycle->start)
+        return generation;
+    return cycle->start + (generation - cycle->start) % cycle->period;
+}
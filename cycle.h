@@ -0,0 +1,35 @@
+//
+// Still life and oscillator detection from one grid hash per generation.
+//
+
+#ifndef GOL_CYCLE_H
+#define GOL_CYCLE_H
+
+#include <stdint.h>
+
+// the hashes of the last slots generations, nothing in the window is evicted by another hash
+struct CycleDetector {
+    int slots; // power of two, also the longest period found
+    uint64_t *hashes; // ring, generation % slots
+    uint64_t *generations;
+
+    // open addressing from a hash to the last generation in the window that had it, twice the slots
+    uint64_t *table_hashes;
+    uint64_t *table_generations;
+
+    uint64_t period; // once confirmed
+    uint64_t start; // first generation of the cycle
+};
+
+// hashes == nullptr when the allocation failed
+struct CycleDetector CreateCycleDetector(int slots);
+void FreeCycleDetector(struct CycleDetector *cycle);
+void ResetCycleDetector(struct CycleDetector *cycle);
+
+// feed generations in order, returns the period once a hash comes back within the window, 0 before
+uint64_t ObserveGeneration(struct CycleDetector *cycle, uint64_t generation, uint64_t hash);
+
+// earliest generation with the same cells as generation, once a cycle is known
+uint64_t CycleEquivalent(struct CycleDetector const *cycle, uint64_t generation);
+
+#endif //GOL_CYCLE_H
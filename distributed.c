@@ -0,0 +1,291 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "distributed.h"
+#include "bitlife.h"
+#include "vectorized.h"
+#include "smoothlife.h"
+#include "rng.h"
+#include "timing.h"
+
+#ifndef _WIN32
+
+// the rows [first, first + rows) of the torus, stored with a halo row above them and one below
+struct Strip {
+    enum DistributedEngine engine;
+    int first;
+    int rows;
+    int width;
+    size_t row_size; // bytes
+
+    struct BitGrid grid, newGrid; // DISTRIBUTED_BITS
+    struct BitRuleKernel kernel;
+    float *data, *newData; // the float engines, rows + 2 of width, x2 for value + heat
+};
+
+static size_t RowSize(enum DistributedEngine const engine, int const width)
+{
+    switch (engine) {
+    case DISTRIBUTED_BITS:
+        return (size_t)(width + 63) / 64 * sizeof(uint64_t);
+    case DISTRIBUTED_FLOAT:
+        return (size_t)width * 2 * sizeof(float);
+    case DISTRIBUTED_SMOOTH:
+        return (size_t)width * sizeof(float);
+    }
+    return 0;
+}
+
+// local row y of the current board, 0 and rows + 1 being the halo
+static unsigned char * StripRow(struct Strip const *strip, int const y)
+{
+    if (strip->engine == DISTRIBUTED_BITS)
+        return (unsigned char *)(strip->grid.cells + (long)y * strip->grid.words);
+    return (unsigned char *)strip->data + (size_t)y * strip->row_size;
+}
+
+static bool CreateStrip(struct Strip *strip, struct DistributedSettings const *settings, int const rank)
+{
+    int const first = (int)((long)settings->height * rank / settings->processes);
+    int const last = (int)((long)settings->height * (rank + 1) / settings->processes);
+    int const width = settings->width;
+
+    *strip = (struct Strip){
+        .engine = settings->engine, .first = first, .rows = last - first, .width = width,
+        .row_size = RowSize(settings->engine, width),
+    };
+
+    if (strip->engine == DISTRIBUTED_BITS) {
+        strip->grid = CreateBitGrid(strip->rows + 2, width);
+        strip->newGrid = CreateBitGrid(strip->rows + 2, width);
+        if (strip->grid.cells == nullptr || strip->newGrid.cells == nullptr)
+            return false;
+        strip->kernel = SelectBitRuleKernel(settings->rule);
+
+        // InitBitLifeRows numbered by the row of the torus, not of the strip
+        int const tail = width % 64;
+        for (int y = 1; y <= strip->rows; ++y) {
+            uint64_t *row = (uint64_t *)StripRow(strip, y);
+            for (int j = 0; j < strip->grid.words; ++j)
+                row[j] = RandomCellWord(settings->seed, first + y - 1, j * 64);
+            if (tail != 0)
+                row[strip->grid.words - 1] &= ((uint64_t)1 << tail) - 1;
+        }
+        return true;
+    }
+
+    strip->data = malloc((size_t)(strip->rows + 2) * strip->row_size);
+    strip->newData = malloc((size_t)(strip->rows + 2) * strip->row_size);
+    if (strip->data == nullptr || strip->newData == nullptr)
+        return false;
+
+    // InitConway and the soups of InitSmoothworld
+    for (int y = 1; y <= strip->rows; ++y) {
+        float *row = (float *)StripRow(strip, y);
+        uint64_t bits = 0;
+        for (int x = 0; x < width; ++x) {
+            if (x % 64 == 0)
+                bits = RandomCellWord(settings->seed, first + y - 1, x);
+            float const cell = (float)(bits >> (x % 64) & 1);
+            if (strip->engine == DISTRIBUTED_FLOAT) {
+                row[2 * x] = cell;
+                row[2 * x + 1] = 1;
+            } else {
+                row[x] = cell;
+            }
+        }
+    }
+    return true;
+}
+
+static void FreeStrip(struct Strip *strip)
+{
+    FreeBitGrid(&strip->grid);
+    FreeBitGrid(&strip->newGrid);
+    free(strip->data);
+    free(strip->newData);
+}
+
+// local rows [begin, end), none of them wraps since the halo rows are there
+static void StepStripRows(struct Strip *strip, int const begin, int const end)
+{
+    int const height = strip->rows + 2, width = strip->width;
+
+    switch (strip->engine) {
+    case DISTRIBUTED_BITS:
+        IterateBitRuleRows(&strip->kernel, &strip->grid, &strip->newGrid, begin, end);
+        break;
+    case DISTRIBUTED_FLOAT:
+        IterateConwayVectorizedRows(height, width, (void *)strip->data, (void *)strip->newData, begin, end);
+        break;
+    case DISTRIBUTED_SMOOTH:
+        StepSmoothWorldRows(height, width, (void *)strip->data, (void *)strip->newData, begin, end);
+        break;
+    }
+}
+
+static void SwapStrip(struct Strip *strip)
+{
+    struct BitGrid const grid = strip->grid;
+    strip->grid = strip->newGrid;
+    strip->newGrid = grid;
+    float *data = strip->data;
+    strip->data = strip->newData;
+    strip->newData = data;
+}
+
+static bool StepStrip(struct Strip *strip, struct HaloTransport const *halo)
+{
+    int const rows = strip->rows;
+
+    // the inner rows only read the strip itself, they run while the edge rows travel
+    if (!halo->post(halo->state, StripRow(strip, 1), StripRow(strip, rows)))
+        return false;
+    if (rows > 2)
+        StepStripRows(strip, 2, rows);
+    if (!halo->wait(halo->state, StripRow(strip, 0), StripRow(strip, rows + 1)))
+        return false;
+    StepStripRows(strip, 1, 2);
+    if (rows > 1)
+        StepStripRows(strip, rows, rows + 1);
+
+    SwapStrip(strip);
+    return true;
+}
+
+// a sum over the rows of the torus, the strips add theirs up in any order
+static void MeasureStrip(struct Strip const *strip, struct DistributedResult *result)
+{
+    for (int y = 1; y <= strip->rows; ++y) {
+        unsigned char const *row = StripRow(strip, y);
+        uint64_t const key = RandomMix((uint64_t)(strip->first + y - 1));
+
+        for (size_t i = 0; i < strip->row_size; i += sizeof(uint32_t)) {
+            uint32_t word;
+            memcpy(&word, row + i, sizeof word);
+            result->hash += RandomMix(RandomMix(key + i) ^ word);
+        }
+
+        if (strip->engine == DISTRIBUTED_BITS) {
+            for (int j = 0; j < strip->grid.words; ++j)
+                result->population += PopCount64(((uint64_t const *)row)[j]);
+        } else if (strip->engine == DISTRIBUTED_FLOAT) {
+            for (int x = 0; x < strip->width; ++x)
+                result->population += ((float const *)row)[2 * x] != 0;
+        } else {
+            for (int x = 0; x < strip->width; ++x)
+                result->population += ((float const *)row)[x] > .5f;
+        }
+    }
+}
+
+static bool RunStrip(struct DistributedSettings const *settings, struct HaloNetwork *network, int const rank,
+                     struct DistributedResult *result)
+{
+    struct Strip strip;
+    struct HaloTransport halo;
+    bool ok = CreateStrip(&strip, settings, rank) && OpenHalo(network, rank, &halo);
+    if (!ok) {
+        fprintf(stderr, "fail to allocate strip %d\n", rank);
+        FreeStrip(&strip);
+        return false;
+    }
+
+    double const start = WallSeconds();
+    for (uint64_t generation = 0; ok && generation < settings->generations; ++generation)
+        ok = StepStrip(&strip, &halo);
+    result->seconds = WallSeconds() - start;
+    if (ok)
+        MeasureStrip(&strip, result);
+    else
+        fprintf(stderr, "strip %d lost a neighbour\n", rank);
+
+    halo.close(halo.state);
+    FreeStrip(&strip);
+    return ok;
+}
+
+bool RunDistributed(struct DistributedSettings const *settings, struct DistributedResult *result)
+{
+    int const count = settings->processes;
+    *result = (struct DistributedResult){0};
+    if (count <= 0 || count > settings->height)
+        return false;
+
+    struct HaloNetwork *network = CreateHaloNetwork(settings->transport, count,
+                                                    RowSize(settings->engine, settings->width));
+    struct DistributedResult *results = mmap(nullptr, count * sizeof *results, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t *children = calloc(count, sizeof *children);
+    if (network == nullptr || results == MAP_FAILED || children == nullptr) {
+        fprintf(stderr, "fail to set up %d processes\n", count);
+        exit(EXIT_FAILURE);
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    bool ok = true;
+    int started = 0;
+    for (; started < count; ++started) {
+        children[started] = fork();
+        if (children[started] < 0) {
+            ok = false;
+            break;
+        }
+        if (children[started] == 0)
+            _exit(RunStrip(settings, network, started, &results[started]) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    // the children hold their own copies of the links from here on
+    FreeHaloNetwork(network);
+
+    if (!ok) {
+        fprintf(stderr, "fail to start process %d\n", started);
+        for (int i = 0; i < started; ++i)
+            kill(children[i], SIGTERM);
+    }
+
+    for (int remaining = started; remaining > 0; --remaining) {
+        int status;
+        pid_t const child = wait(&status);
+        if (child < 0)
+            break;
+        if (ok && (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)) {
+            // a neighbour waiting on shared memory would spin forever on that one
+            ok = false;
+            for (int i = 0; i < started; ++i)
+                if (children[i] != child)
+                    kill(children[i], SIGTERM);
+        }
+    }
+
+    for (int i = 0; ok && i < count; ++i) {
+        result->population += results[i].population;
+        result->hash += results[i].hash;
+        if (results[i].seconds > result->seconds)
+            result->seconds = results[i].seconds;
+    }
+
+    munmap(results, count * sizeof *results);
+    free(children);
+    return ok;
+}
+
+#else
+
+bool RunDistributed(struct DistributedSettings const *settings, struct DistributedResult *result)
+{
+    (void)settings;
+    *result = (struct DistributedResult){0};
+    fprintf(stderr, "the processes need fork, not there on Windows\n");
+    return false;
+}
+
+#endif
@@ -0,0 +1,41 @@
+//
+// One torus cut in horizontal strips, each stepped by its own process, trading one halo row with each neighbour.
+//
+
+#ifndef GOL_DISTRIBUTED_H
+#define GOL_DISTRIBUTED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "halo.h"
+#include "liferule.h"
+
+enum DistributedEngine {
+    DISTRIBUTED_BITS, // the rule kernels of bitlife, any B/S rule
+    DISTRIBUTED_FLOAT, // IterateConwayVectorizedRows, value + heat, B3/S23 only
+    DISTRIBUTED_SMOOTH, // StepSmoothWorldRows
+};
+
+struct DistributedSettings {
+    enum DistributedEngine engine;
+    enum HaloTransportKind transport;
+    int processes; // strips, at most height
+    int height;
+    int width;
+    struct LifeRule rule; // of DISTRIBUTED_BITS
+    uint64_t seed; // of the soup, the same cells as one process would get
+    uint64_t generations;
+};
+
+struct DistributedResult {
+    uint64_t population; // living cells, cells above one half for smooth
+    uint64_t hash; // of the whole board, the same whatever the number of processes
+    double seconds; // stepping, of the slowest process
+};
+
+// forks one process per strip and waits for all of them, Linux and the other POSIX systems only;
+// false when one of them failed, the others are stopped then
+bool RunDistributed(struct DistributedSettings const *settings, struct DistributedResult *result);
+
+#endif //GOL_DISTRIBUTED_H
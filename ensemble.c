@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "ensemble.h"
+#include "bitlife.h"
+#include "cycle.h"
+#include "wolfram.h"
+#include "timing.h"
+
+struct EnsembleShared {
+    struct EnsembleRun const *runs;
+    size_t count;
+    struct EnsembleSettings const *settings;
+    EnsembleDone done;
+    void *context;
+    atomic_size_t next;
+    atomic_bool failed;
+};
+
+static void ObservePopulation(struct EnsembleResult *result, uint64_t const population)
+{
+    result->population = population;
+    if (population < result->min_population)
+        result->min_population = population;
+    if (population > result->max_population)
+        result->max_population = population;
+}
+
+// like CreateConway centres a pattern file, the cells falling off the board are dropped
+static void PastePattern(struct BitGrid *grid, struct BitGrid const *pattern)
+{
+    int const top = (grid->height - pattern->height) / 2, left = (grid->width - pattern->width) / 2;
+    for (int y = 0; y < pattern->height; ++y) {
+        if (top + y < 0 || top + y >= grid->height)
+            continue;
+        uint64_t *row = grid->cells + (long)(top + y) * grid->words;
+        for (int j = 0; j < pattern->words; ++j) {
+            uint64_t const word = pattern->cells[(long)y * pattern->words + j];
+            for (int b = 0; word >> b != 0; ++b) {
+                int const x = left + 64 * j + b;
+                if (word >> b & 1 && x >= 0 && x < grid->width)
+                    row[x / 64] |= 1ull << (x % 64);
+            }
+        }
+    }
+}
+
+static bool RunLife(struct EnsembleRun const *run, struct EnsembleSettings const *settings,
+                    struct EnsembleResult *result)
+{
+    struct BitGrid grid = CreateBitGrid(run->height, run->width);
+    struct BitGrid next = CreateBitGrid(run->height, run->width);
+    struct TileTracker tiles = {0};
+    struct CycleDetector cycle = {0};
+    bool const ok = grid.cells != nullptr && next.cells != nullptr
+                    && (tiles = CreateTileTracker(&grid)).changed != nullptr
+                    && (cycle = CreateCycleDetector(settings->cycle_history)).hashes != nullptr;
+
+    if (ok) {
+        struct BitRuleKernel const kernel = SelectBitRuleKernel(run->rule);
+        if (run->pattern != nullptr)
+            PastePattern(&grid, run->pattern);
+        else
+            InitBitLifeRows(&grid, run->seed, 0, grid.height);
+
+        uint64_t hash = HashBitGrid(&grid);
+        ObserveGeneration(&cycle, 0, hash);
+        result->initial_population = result->min_population = (uint64_t)CountBitLife(&grid);
+        ObservePopulation(result, result->initial_population);
+
+        for (uint64_t generation = 1; generation <= settings->generations; ++generation) {
+            PrepareTiles(&tiles);
+            IterateBitRuleTileRows(&kernel, &grid, &next, &tiles, 0, tiles.rows);
+            hash += TileHashChange(&tiles);
+            struct BitGrid const swap = grid;
+            grid = next;
+            next = swap;
+
+            result->generations = generation;
+            ObservePopulation(result, (uint64_t)CountBitLife(&grid));
+            uint64_t const period = ObserveGeneration(&cycle, generation, hash);
+            if (period != 0) {
+                result->period = period;
+                result->cycle_start = cycle.start;
+                break;
+            }
+        }
+        result->hash = hash;
+    }
+
+    FreeBitGrid(&grid);
+    FreeBitGrid(&next);
+    FreeTileTracker(&tiles);
+    FreeCycleDetector(&cycle);
+    return ok;
+}
+
+static bool RunWolfram(struct EnsembleRun const *run, struct EnsembleSettings const *settings,
+                       struct EnsembleResult *result)
+{
+    struct WolfRow row = CreateWolfRow(run->width);
+    struct WolfRow next = CreateWolfRow(run->width);
+    struct WolfKernel const kernel = SelectWolfKernel(run->wolfram_rule);
+    bool const ok = row.cells != nullptr && next.cells != nullptr;
+
+    if (ok) {
+        // the single cell LaunchWolfram starts from
+        InitWolfRow(&row);
+        result->initial_population = result->min_population = CountWolfRow(&row);
+        ObservePopulation(result, result->initial_population);
+
+        for (uint64_t generation = 1; generation <= settings->generations; ++generation) {
+            ObservePopulation(result, StepWolfKernel(&kernel, &row, &next));
+            struct WolfRow const swap = row;
+            row = next;
+            next = swap;
+        }
+        result->generations = settings->generations;
+        result->hash = HashWolfRow(&row);
+    }
+
+    FreeWolfRow(&row);
+    FreeWolfRow(&next);
+    return ok;
+}
+
+static void EnsembleWorker(void *context, int, int)
+{
+    struct EnsembleShared *shared = context;
+
+    for (;;) {
+        size_t const index = atomic_fetch_add(&shared->next, 1);
+        if (index >= shared->count)
+            break;
+
+        struct EnsembleRun const *run = &shared->runs[index];
+        struct EnsembleResult result = {0};
+        double const start = WallSeconds();
+        bool const ok = run->wolfram ? RunWolfram(run, shared->settings, &result)
+                                     : RunLife(run, shared->settings, &result);
+        result.seconds = WallSeconds() - start;
+
+        if (ok)
+            shared->done(shared->context, index, run, &result);
+        else
+            atomic_store(&shared->failed, true);
+    }
+}
+
+bool RunEnsemble(struct EnsembleRun const *runs, size_t const count, struct EnsembleSettings const *settings,
+                 struct WorkerPool *pool, EnsembleDone const done, void *context)
+{
+    struct EnsembleShared shared = {
+        .runs = runs, .count = count, .settings = settings, .done = done, .context = context,
+    };
+    atomic_init(&shared.next, 0);
+    atomic_init(&shared.failed, false);
+
+    if (pool != nullptr)
+        RunBands(pool, WorkerCount(pool), EnsembleWorker, &shared);
+    else
+        EnsembleWorker(&shared, 0, 1);
+
+    return !atomic_load(&shared.failed);
+}
@@ -0,0 +1,53 @@
+//
+// Many small independent boards, seeds x rules x sizes, one board per worker at a time.
+//
+
+#ifndef GOL_ENSEMBLE_H
+#define GOL_ENSEMBLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "liferule.h"
+#include "bitlife.h"
+#include "wolfram.h"
+#include "workers.h"
+
+struct EnsembleRun {
+    uint64_t seed; // of the soup, unused by the wolfram runs
+    struct BitGrid const *pattern; // centred on the board instead of the soup, nullptr : the soup of seed
+    struct LifeRule rule;
+    bool wolfram; // a one dimensional automaton from a single cell instead, one bit-packed row
+    struct WolfRule wolfram_rule;
+    int height; // unused by the wolfram runs
+    int width;
+};
+
+struct EnsembleSettings {
+    uint64_t generations; // at most, a Life run stops once it cycles
+    int cycle_history; // longest period looked for
+};
+
+struct EnsembleResult {
+    uint64_t generations; // stepped
+    uint64_t initial_population;
+    uint64_t population; // of the board, of the last generation for wolfram
+    uint64_t min_population;
+    uint64_t max_population;
+    uint64_t period; // 0 : no cycle found, 1 : still life or empty
+    uint64_t cycle_start;
+    uint64_t hash; // HashBitGrid of the last board, HashWolfRow for wolfram
+    double seconds;
+};
+
+// called from the worker that ran it, in whatever order the runs finish
+typedef void (*EnsembleDone)(void *context, size_t index, struct EnsembleRun const *run,
+                             struct EnsembleResult const *result);
+
+// each worker takes the next run from a shared counter, a long run does not hold back the others;
+// false when a board could not be allocated, the runs after it are still done
+bool RunEnsemble(struct EnsembleRun const *runs, size_t count, struct EnsembleSettings const *settings,
+                 struct WorkerPool *pool, EnsembleDone done, void *context);
+
+#endif //GOL_ENSEMBLE_H
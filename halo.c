@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "halo.h"
+
+struct HaloNetwork {
+    enum HaloTransportKind kind;
+    int count;
+    size_t size;
+
+    // shared memory : one mailbox of mailbox_size bytes per strip
+    unsigned char *mailboxes;
+    size_t mailbox_size;
+
+    // sockets : links[i][0] is the end of strip i, links[i][1] the one of strip i + 1 below it
+    int (*links)[2];
+};
+
+#ifndef _WIN32
+
+// written by two different neighbours, one cache line each
+struct Mailbox {
+    alignas(64) _Atomic uint64_t from_above; // rows posted so far by the strip above
+    alignas(64) _Atomic uint64_t from_below;
+};
+
+// followed by two generations of rows, a neighbour never gets more than one generation ahead
+static unsigned char * MailboxRow(struct HaloNetwork const *network, int const rank, uint64_t const generation,
+                                  bool const from_below)
+{
+    return network->mailboxes + rank * network->mailbox_size + sizeof(struct Mailbox)
+           + ((generation & 1) * 2 + from_below) * network->size;
+}
+
+static struct Mailbox * MailboxOf(struct HaloNetwork const *network, int const rank)
+{
+    return (struct Mailbox *)(network->mailboxes + rank * network->mailbox_size);
+}
+
+struct SharedHalo {
+    struct HaloNetwork const *network;
+    int rank;
+    int above;
+    int below;
+    uint64_t posted;
+    uint64_t received;
+};
+
+static bool PostShared(void *state, void const *up, void const *down)
+{
+    struct SharedHalo *halo = state;
+    struct HaloNetwork const *network = halo->network;
+    uint64_t const generation = halo->posted++;
+
+    // our first row is what the strip above has below it
+    memcpy(MailboxRow(network, halo->above, generation, true), up, network->size);
+    atomic_store_explicit(&MailboxOf(network, halo->above)->from_below, generation + 1, memory_order_release);
+    memcpy(MailboxRow(network, halo->below, generation, false), down, network->size);
+    atomic_store_explicit(&MailboxOf(network, halo->below)->from_above, generation + 1, memory_order_release);
+    return true;
+}
+
+static void AwaitRow(_Atomic uint64_t *posted, uint64_t const count)
+{
+    for (int spins = 0; atomic_load_explicit(posted, memory_order_acquire) < count; ++spins)
+        if (spins > 64)
+            sched_yield();
+}
+
+static bool WaitShared(void *state, void *up, void *down)
+{
+    struct SharedHalo *halo = state;
+    struct HaloNetwork const *network = halo->network;
+    struct Mailbox *mailbox = MailboxOf(network, halo->rank);
+    uint64_t const generation = halo->received++;
+
+    AwaitRow(&mailbox->from_above, generation + 1);
+    memcpy(up, MailboxRow(network, halo->rank, generation, false), network->size);
+    AwaitRow(&mailbox->from_below, generation + 1);
+    memcpy(down, MailboxRow(network, halo->rank, generation, true), network->size);
+    return true;
+}
+
+struct SocketHalo {
+    size_t size;
+    int fds[2]; // above, below
+    unsigned char const *send[2];
+    size_t sent[2];
+    unsigned char *receive[2];
+    size_t received[2];
+};
+
+// moves whatever the sockets take or have without blocking, false once a neighbour hung up
+static bool PumpSockets(struct SocketHalo *halo)
+{
+    for (int side = 0; side < 2; ++side) {
+        while (halo->sent[side] < halo->size) {
+            ssize_t const n = send(halo->fds[side], halo->send[side] + halo->sent[side],
+                                   halo->size - halo->sent[side], MSG_NOSIGNAL);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n < 0 && errno != EINTR)
+                return false;
+            if (n > 0)
+                halo->sent[side] += (size_t)n;
+        }
+        while (halo->receive[side] != nullptr && halo->received[side] < halo->size) {
+            ssize_t const n = recv(halo->fds[side], halo->receive[side] + halo->received[side],
+                                   halo->size - halo->received[side], 0);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n == 0 || (n < 0 && errno != EINTR))
+                return false;
+            if (n > 0)
+                halo->received[side] += (size_t)n;
+        }
+    }
+    return true;
+}
+
+static bool PostSockets(void *state, void const *up, void const *down)
+{
+    struct SocketHalo *halo = state;
+    halo->send[0] = up;
+    halo->send[1] = down;
+    halo->sent[0] = halo->sent[1] = 0;
+    halo->receive[0] = halo->receive[1] = nullptr;
+    return PumpSockets(halo);
+}
+
+static bool WaitSockets(void *state, void *up, void *down)
+{
+    struct SocketHalo *halo = state;
+    halo->receive[0] = up;
+    halo->receive[1] = down;
+    halo->received[0] = halo->received[1] = 0;
+
+    for (;;) {
+        if (!PumpSockets(halo))
+            return false;
+
+        struct pollfd fds[2];
+        int count = 0;
+        for (int side = 0; side < 2; ++side) {
+            short const events = (short)((halo->sent[side] < halo->size ? POLLOUT : 0)
+                                         | (halo->received[side] < halo->size ? POLLIN : 0));
+            if (events != 0)
+                fds[count++] = (struct pollfd){.fd = halo->fds[side], .events = events};
+        }
+        if (count == 0)
+            return true;
+        if (poll(fds, (nfds_t)count, -1) < 0 && errno != EINTR)
+            return false;
+    }
+}
+
+static void CloseHalo(void *state)
+{
+    free(state);
+}
+
+#endif
+
+struct HaloNetwork * CreateHaloNetwork(enum HaloTransportKind const kind, int const count, size_t const size)
+{
+#ifdef _WIN32
+    (void)kind, (void)count, (void)size;
+    return nullptr;
+#else
+    if (count <= 0)
+        return nullptr;
+    struct HaloNetwork *network = calloc(1, sizeof *network);
+    if (network == nullptr)
+        return nullptr;
+    *network = (struct HaloNetwork){.kind = kind, .count = count, .size = size};
+
+    if (kind == HALO_SHARED_MEMORY) {
+        network->mailbox_size = (sizeof(struct Mailbox) + 4 * size + 63) & ~(size_t)63;
+        void *mailboxes = mmap(nullptr, count * network->mailbox_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mailboxes == MAP_FAILED) {
+            free(network);
+            return nullptr;
+        }
+        // fresh anonymous pages are zero, no row posted yet
+        network->mailboxes = mailboxes;
+        return network;
+    }
+
+    network->links = malloc(count * sizeof *network->links);
+    if (network->links == nullptr) {
+        free(network);
+        return nullptr;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, network->links[i]) != 0) {
+            network->count = i;
+            FreeHaloNetwork(network);
+            return nullptr;
+        }
+    }
+    return network;
+#endif
+}
+
+void FreeHaloNetwork(struct HaloNetwork *network)
+{
+    if (network == nullptr)
+        return;
+#ifndef _WIN32
+    if (network->mailboxes != nullptr)
+        munmap(network->mailboxes, network->count * network->mailbox_size);
+    if (network->links != nullptr) {
+        for (int i = 0; i < network->count; ++i) {
+            close(network->links[i][0]);
+            close(network->links[i][1]);
+        }
+        free(network->links);
+    }
+#endif
+    free(network);
+}
+
+bool OpenHalo(struct HaloNetwork *network, int const rank, struct HaloTransport *transport)
+{
+#ifdef _WIN32
+    (void)network, (void)rank, (void)transport;
+    return false;
+#else
+    int const above = (rank + network->count - 1) % network->count;
+    int const below = (rank + 1) % network->count;
+
+    if (network->kind == HALO_SHARED_MEMORY) {
+        struct SharedHalo *halo = malloc(sizeof *halo);
+        if (halo == nullptr)
+            return false;
+        *halo = (struct SharedHalo){.network = network, .rank = rank, .above = above, .below = below};
+        *transport = (struct HaloTransport){halo, PostShared, WaitShared, CloseHalo};
+        return true;
+    }
+
+    struct SocketHalo *halo = malloc(sizeof *halo);
+    if (halo == nullptr)
+        return false;
+    *halo = (struct SocketHalo){
+        .size = network->size,
+        .fds = {network->links[above][1], network->links[rank][0]},
+    };
+    // the other links belong to other strips, closing them here lets a dead neighbour
+    // show up as a hang up once the parent closed its copies too
+    for (int i = 0; i < network->count; ++i) {
+        if (i != above && i != rank) {
+            close(network->links[i][0]);
+            close(network->links[i][1]);
+        } else if (i != above) {
+            close(network->links[i][1]);
+        } else if (i != rank) {
+            close(network->links[i][0]);
+        }
+    }
+    fcntl(halo->fds[0], F_SETFL, fcntl(halo->fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(halo->fds[1], F_SETFL, fcntl(halo->fds[1], F_GETFL) | O_NONBLOCK);
+    *transport = (struct HaloTransport){halo, PostSockets, WaitSockets, CloseHalo};
+    return true;
+#endif
+}
@@ -0,0 +1,37 @@
+//
+// Halo rows between the strips of a torus owned by different processes, over shared memory or Unix sockets.
+//
+
+#ifndef GOL_HALO_H
+#define GOL_HALO_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+enum HaloTransportKind {
+    HALO_SHARED_MEMORY, // a mailbox per strip in an anonymous shared mapping
+    HALO_SOCKETS, // a socketpair between each pair of neighbours
+};
+
+// the end held by one strip; another transport, a network one, only has to fill in the same calls
+struct HaloTransport {
+    void *state;
+    // starts sending up to the strip above and down to the strip below, both rows stay untouched until wait
+    bool (*post)(void *state, void const *up, void const *down);
+    // the last row of the strip above into up, the first row of the strip below into down,
+    // returns once the posted rows went out as well; false when a neighbour went away
+    bool (*wait)(void *state, void *up, void *down);
+    void (*close)(void *state);
+};
+
+// the links of every strip of the ring, created before forking
+struct HaloNetwork;
+
+// count strips exchanging rows of size bytes, the last one being above the first; nullptr on failure
+struct HaloNetwork * CreateHaloNetwork(enum HaloTransportKind kind, int count, size_t size);
+void FreeHaloNetwork(struct HaloNetwork *network);
+
+// the end of strip rank, in the process that owns it; false without memory
+bool OpenHalo(struct HaloNetwork *network, int rank, struct HaloTransport *transport);
+
+#endif //GOL_HALO_H
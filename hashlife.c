@@ -0,0 +1,577 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "hashlife.h"
+#include "lifelut.h"
+
+// node 0 means "no node", 1 and 2 are the two level 0 leaves
+#define NONE 0u
+#define DEAD 1u
+#define ALIVE 2u
+
+#define MAX_LEVEL 62
+
+// a square of 2^level cells, children are indices so the arena can move
+struct Node {
+    uint32_t nw, ne, sw, se;
+    uint32_t next; // hash chain, or free list once collected
+    uint32_t result; // centre advanced by 2^step generations
+    uint64_t population;
+    uint8_t level;
+    int8_t step;
+    bool marked;
+};
+
+struct HashLife {
+    struct Node *nodes;
+    uint32_t count; // slots handed out so far
+    uint32_t capacity;
+    uint32_t budget; // slots allowed before collecting
+    uint32_t live;
+    uint32_t free_list;
+
+    uint32_t *buckets;
+    uint32_t bucket_mask;
+
+    uint32_t empty[MAX_LEVEL + 2];
+
+    // nodes held by the recursion, collection must keep them alive
+    uint32_t *keep;
+    size_t kept;
+    size_t keep_capacity;
+    bool loading;
+
+    // 4x4 to 2x2 table of the rule, the leaves of every jump
+    struct LifeLut lut;
+
+    uint32_t root; // covers [-2^(level-1), 2^(level-1)) on both axes
+    uint64_t generation;
+};
+
+static void Collect(struct HashLife *life);
+
+static uint32_t HashNode(uint32_t const nw, uint32_t const ne, uint32_t const sw, uint32_t const se)
+{
+    uint64_t h = nw * 0x9E3779B97F4A7C15ull;
+    h = (h ^ ne) * 0xC2B2AE3D27D4EB4Full;
+    h = (h ^ sw) * 0x165667B19E3779F9ull;
+    h = (h ^ se) * 0x27D4EB2F165667C5ull;
+    return (uint32_t)(h >> 32);
+}
+
+static void Keep(struct HashLife *life, uint32_t const node)
+{
+    if (life->kept == life->keep_capacity) {
+        life->keep_capacity = life->keep_capacity ? life->keep_capacity * 2 : 256;
+        life->keep = realloc(life->keep, life->keep_capacity * sizeof *life->keep);
+        if (life->keep == nullptr) {
+            fprintf(stderr, "fail to grow the hashlife keep stack\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    life->keep[life->kept++] = node;
+}
+
+static void Rehash(struct HashLife *life, uint32_t const buckets)
+{
+    free(life->buckets);
+    life->buckets = calloc(buckets, sizeof *life->buckets);
+    if (life->buckets == nullptr) {
+        fprintf(stderr, "fail to allocate %u hashlife buckets\n", buckets);
+        exit(EXIT_FAILURE);
+    }
+    life->bucket_mask = buckets - 1;
+
+    for (uint32_t i = ALIVE + 1; i < life->count; ++i) {
+        struct Node *node = &life->nodes[i];
+        if (node->level == 0)
+            continue; // free slot
+        uint32_t const h = HashNode(node->nw, node->ne, node->sw, node->se) & life->bucket_mask;
+        node->next = life->buckets[h];
+        life->buckets[h] = i;
+    }
+}
+
+static uint32_t AllocNode(struct HashLife *life)
+{
+    if (life->free_list == NONE && life->count == life->capacity) {
+        if (life->count >= life->budget && !life->loading)
+            Collect(life);
+
+        if (life->free_list == NONE && life->count == life->capacity) {
+            uint32_t capacity = life->capacity * 2;
+            if (capacity > life->budget && life->capacity < life->budget)
+                capacity = life->budget;
+            struct Node *nodes = realloc(life->nodes, (size_t)capacity * sizeof *nodes);
+            if (nodes == nullptr) {
+                fprintf(stderr, "fail to grow the hashlife arena to %u nodes\n", capacity);
+                exit(EXIT_FAILURE);
+            }
+            life->nodes = nodes;
+            life->capacity = capacity;
+        }
+    }
+
+    uint32_t index;
+    if (life->free_list != NONE) {
+        index = life->free_list;
+        life->free_list = life->nodes[index].next;
+    } else {
+        index = life->count++;
+    }
+    life->live++;
+
+    return index;
+}
+
+// the canonical node with these four children, created on first use
+static uint32_t Join(struct HashLife *life, uint32_t const nw, uint32_t const ne, uint32_t const sw, uint32_t const se)
+{
+    uint32_t const h = HashNode(nw, ne, sw, se);
+
+    for (uint32_t i = life->buckets[h & life->bucket_mask]; i != NONE; i = life->nodes[i].next) {
+        struct Node const *node = &life->nodes[i];
+        if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se)
+            return i;
+    }
+
+    // may collect, move the arena or rebuild the buckets
+    uint32_t const index = AllocNode(life);
+
+    struct Node *nodes = life->nodes;
+    nodes[index] = (struct Node){
+        .nw = nw, .ne = ne, .sw = sw, .se = se,
+        .result = NONE,
+        .population = nodes[nw].population + nodes[ne].population + nodes[sw].population + nodes[se].population,
+        .level = (uint8_t)(nodes[nw].level + 1),
+        .step = -1,
+    };
+
+    if (life->live > life->bucket_mask)
+        Rehash(life, (life->bucket_mask + 1) * 2);
+    else {
+        uint32_t const b = h & life->bucket_mask;
+        nodes[index].next = life->buckets[b];
+        life->buckets[b] = index;
+    }
+
+    return index;
+}
+
+static void Mark(struct Node *nodes, uint32_t const index)
+{
+    struct Node *node = &nodes[index];
+    if (node->marked)
+        return;
+    node->marked = true;
+    if (node->level > 0) {
+        Mark(nodes, node->nw);
+        Mark(nodes, node->ne);
+        Mark(nodes, node->sw);
+        Mark(nodes, node->se);
+    }
+}
+
+// drops every node not reachable from the root, the empty squares or the keep stack
+static void Collect(struct HashLife *life)
+{
+    struct Node *nodes = life->nodes;
+
+    for (uint32_t i = 0; i < life->count; ++i)
+        nodes[i].marked = false;
+
+    nodes[NONE].marked = nodes[DEAD].marked = nodes[ALIVE].marked = true;
+    for (int level = 0; level <= MAX_LEVEL + 1; ++level)
+        Mark(nodes, life->empty[level]);
+    Mark(nodes, life->root);
+    for (size_t i = 0; i < life->kept; ++i)
+        Mark(nodes, life->keep[i]);
+
+    life->free_list = NONE;
+    life->live = ALIVE + 1;
+    for (uint32_t i = life->count - 1; i > ALIVE; --i) {
+        if (nodes[i].marked) {
+            life->live++;
+            if (nodes[i].result != NONE && !nodes[nodes[i].result].marked)
+                nodes[i].result = NONE;
+        } else {
+            nodes[i].level = 0;
+            nodes[i].next = life->free_list;
+            life->free_list = i;
+        }
+    }
+
+    // what is still needed barely fits, the budget has to give or we collect on every node
+    if (life->live > life->budget - life->budget / 4) {
+        fprintf(stderr, "hashlife: %u live nodes, growing the budget past %u\n", life->live, life->budget);
+        life->budget *= 2;
+    }
+
+    Rehash(life, life->bucket_mask + 1);
+}
+
+struct HashLife * CreateHashLife(size_t const memory_budget)
+{
+    struct HashLife *life = calloc(1, sizeof *life);
+    if (life == nullptr)
+        return nullptr;
+
+    size_t budget = memory_budget / (sizeof(struct Node) + sizeof(uint32_t));
+    if (budget < 1024)
+        budget = 1024;
+    if (budget > UINT32_MAX / 2)
+        budget = UINT32_MAX / 2;
+    life->budget = (uint32_t)budget;
+
+    life->capacity = 1024;
+    life->nodes = calloc(life->capacity, sizeof *life->nodes);
+    if (life->nodes == nullptr) {
+        free(life);
+        return nullptr;
+    }
+    life->nodes[DEAD] = (struct Node){.population = 0, .step = -1};
+    life->nodes[ALIVE] = (struct Node){.population = 1, .step = -1};
+    life->count = ALIVE + 1;
+    life->live = ALIVE + 1;
+
+    Rehash(life, 1024);
+    BuildLifeLut(&life->lut, CONWAY_LIFE_RULE);
+
+    life->loading = true;
+    life->empty[0] = DEAD;
+    for (int level = 1; level <= MAX_LEVEL + 1; ++level) {
+        uint32_t const e = life->empty[level - 1];
+        life->empty[level] = Join(life, e, e, e, e);
+    }
+    life->root = life->empty[3];
+    life->loading = false;
+
+    return life;
+}
+
+void FreeHashLife(struct HashLife *life)
+{
+    if (life == nullptr)
+        return;
+    free(life->nodes);
+    free(life->buckets);
+    free(life->keep);
+    free(life);
+}
+
+// the square of side 2^level whose top left corner is (x, y)
+static uint32_t BuildFromBits(struct HashLife *life, struct BitGrid const *grid, int const level, long long const x, long long const y)
+{
+    if (x >= grid->width || y >= grid->height)
+        return life->empty[level];
+    if (level == 0)
+        return GetBitCell(grid, (int)y, (int)x) ? ALIVE : DEAD;
+
+    long long const half = 1ll << (level - 1);
+    uint32_t const nw = BuildFromBits(life, grid, level - 1, x, y);
+    uint32_t const ne = BuildFromBits(life, grid, level - 1, x + half, y);
+    uint32_t const sw = BuildFromBits(life, grid, level - 1, x, y + half);
+    uint32_t const se = BuildFromBits(life, grid, level - 1, x + half, y + half);
+
+    return Join(life, nw, ne, sw, se);
+}
+
+void LoadHashLifeBits(struct HashLife *life, struct BitGrid const *grid)
+{
+    int level = 3;
+    while ((1ll << (level - 1)) < grid->width || (1ll << (level - 1)) < grid->height)
+        level++;
+
+    // the board fills the south east quadrant of the root, whose centre is (0, 0)
+    life->loading = true;
+    uint32_t const quadrant = BuildFromBits(life, grid, level - 1, 0, 0);
+    uint32_t const e = life->empty[level - 1];
+    life->root = Join(life, e, e, e, quadrant);
+    life->loading = false;
+
+    life->generation = 0;
+}
+
+// 8x8 cells, bit 8 * y + x
+static uint32_t BuildFromLeaf(struct HashLife *life, uint64_t const cells, int const level, int const x, int const y)
+{
+    if (level == 0)
+        return cells >> (8 * y + x) & 1 ? ALIVE : DEAD;
+
+    int const half = 1 << (level - 1);
+    uint32_t const nw = BuildFromLeaf(life, cells, level - 1, x, y);
+    uint32_t const ne = BuildFromLeaf(life, cells, level - 1, x + half, y);
+    uint32_t const sw = BuildFromLeaf(life, cells, level - 1, x, y + half);
+    uint32_t const se = BuildFromLeaf(life, cells, level - 1, x + half, y + half);
+
+    return Join(life, nw, ne, sw, se);
+}
+
+uint32_t HashLifeLeaf(struct HashLife *life, uint64_t const cells)
+{
+    life->loading = true;
+    return BuildFromLeaf(life, cells, 3, 0, 0);
+}
+
+uint32_t HashLifeNode(struct HashLife *life, int const level,
+                      uint32_t const nw, uint32_t const ne, uint32_t const sw, uint32_t const se)
+{
+    if (level < 4 || level >= MAX_LEVEL)
+        return 0;
+
+    uint32_t children[4] = {nw, ne, sw, se};
+    for (int q = 0; q < 4; ++q) {
+        if (children[q] == 0)
+            children[q] = life->empty[level - 1];
+        else if (children[q] >= life->count || life->nodes[children[q]].level != level - 1)
+            return 0;
+    }
+
+    life->loading = true;
+    return Join(life, children[0], children[1], children[2], children[3]);
+}
+
+bool SetHashLifeRoot(struct HashLife *life, uint32_t const node)
+{
+    if (node == 0 || node >= life->count || life->nodes[node].level < 3) {
+        life->loading = false;
+        return false;
+    }
+
+    // like LoadHashLifeBits, the pattern fills the south east quadrant
+    uint32_t const e = life->empty[life->nodes[node].level];
+    life->root = Join(life, e, e, e, node);
+    life->loading = false;
+
+    life->generation = 0;
+    return true;
+}
+
+bool SetHashLifeRule(struct HashLife *life, struct LifeRule const rule)
+{
+    // empty space has to stay empty, the recursion never looks at empty nodes
+    if (rule.birth & 1)
+        return false;
+
+    BuildLifeLut(&life->lut, rule);
+    // what was memoized belongs to the previous rule
+    for (uint32_t i = 0; i < life->count; ++i)
+        life->nodes[i].result = NONE;
+
+    return true;
+}
+
+void LoadHashLifeConway(struct HashLife *life, int const height, int const width,
+                        float const (*pixelData)[height][width][2])
+{
+    struct BitGrid grid = CreateBitGrid(height, width);
+    if (grid.cells == nullptr) {
+        fprintf(stderr, "fail to allocate the hashlife load grid\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; x++)
+            if ((*pixelData)[y][x][0] != 0)
+                grid.cells[(long)y * grid.words + x / 64] |= 1ull << (x % 64);
+
+    LoadHashLifeBits(life, &grid);
+    FreeBitGrid(&grid);
+}
+
+// 4x4 cells to the 2x2 centre one generation later
+static uint32_t StepLevel2(struct HashLife *life, uint32_t const index)
+{
+    struct Node const *nodes = life->nodes;
+    struct Node const *node = &nodes[index];
+    uint32_t const quads[4] = {node->nw, node->ne, node->sw, node->se};
+
+    // bit 4 * y + x
+    unsigned cells = 0;
+    for (int q = 0; q < 4; ++q) {
+        struct Node const *quad = &nodes[quads[q]];
+        int const x = (q & 1) * 2, y = (q >> 1) * 2;
+        cells |= (quad->nw == ALIVE) << (4 * y + x);
+        cells |= (quad->ne == ALIVE) << (4 * y + x + 1);
+        cells |= (quad->sw == ALIVE) << (4 * (y + 1) + x);
+        cells |= (quad->se == ALIVE) << (4 * (y + 1) + x + 1);
+    }
+
+    unsigned const block = life->lut.block[cells];
+    uint32_t next[4];
+    for (int i = 0; i < 4; ++i)
+        next[i] = block >> i & 1 ? ALIVE : DEAD;
+
+    return Join(life, next[0], next[1], next[2], next[3]);
+}
+
+// the 2^(level-1) square in the middle of a node, same generation
+static uint32_t Centre(struct HashLife *life, uint32_t const index)
+{
+    struct Node const *nodes = life->nodes;
+    struct Node const *node = &nodes[index];
+    return Join(life, nodes[node->nw].se, nodes[node->ne].sw, nodes[node->sw].ne, nodes[node->se].nw);
+}
+
+// centre of a node advanced by 2^step generations, step <= level - 2
+static uint32_t Successor(struct HashLife *life, uint32_t const index, int const step)
+{
+    struct Node const *node = &life->nodes[index];
+    int const level = node->level;
+
+    if (node->population == 0)
+        return life->empty[level - 1];
+    if (node->result != NONE && node->step == step)
+        return node->result;
+
+    uint32_t result;
+    if (level == 2) {
+        result = StepLevel2(life, index);
+    } else {
+        size_t const kept = life->kept;
+        struct Node const *nodes = life->nodes;
+        struct Node const nw = nodes[node->nw], ne = nodes[node->ne], sw = nodes[node->sw], se = nodes[node->se];
+
+        // nine overlapping squares of 2^(level-1), nodes may move once Join allocates
+        uint32_t sub[9];
+        sub[0] = node->nw;
+        sub[2] = node->ne;
+        sub[6] = node->sw;
+        sub[8] = node->se;
+        Keep(life, sub[1] = Join(life, nw.ne, ne.nw, nw.se, ne.sw));
+        Keep(life, sub[3] = Join(life, nw.sw, nw.se, sw.nw, sw.ne));
+        Keep(life, sub[4] = Join(life, nw.se, ne.sw, sw.ne, se.nw));
+        Keep(life, sub[5] = Join(life, ne.sw, ne.se, se.nw, se.ne));
+        Keep(life, sub[7] = Join(life, sw.ne, se.nw, sw.se, se.sw));
+
+        // full speed spends half of the jump here, a smaller step only recentres
+        bool const full = step == level - 2;
+        uint32_t mid[9];
+        for (int i = 0; i < 9; ++i) {
+            mid[i] = full ? Successor(life, sub[i], step - 1) : Centre(life, sub[i]);
+            Keep(life, mid[i]);
+        }
+
+        int const rest = full ? step - 1 : step;
+        uint32_t quad[4];
+        for (int q = 0; q < 4; ++q) {
+            int const o = (q >> 1) * 3 + (q & 1);
+            uint32_t const square = Join(life, mid[o], mid[o + 1], mid[o + 3], mid[o + 4]);
+            Keep(life, square);
+            quad[q] = Successor(life, square, rest);
+            Keep(life, quad[q]);
+        }
+
+        result = Join(life, quad[0], quad[1], quad[2], quad[3]);
+        life->kept = kept;
+    }
+
+    life->nodes[index].result = result;
+    life->nodes[index].step = (int8_t)step;
+
+    return result;
+}
+
+static bool BorderEmpty(struct HashLife const *life, uint32_t const index)
+{
+    struct Node const *nodes = life->nodes;
+    struct Node const *node = &nodes[index];
+    struct Node const *nw = &nodes[node->nw], *ne = &nodes[node->ne], *sw = &nodes[node->sw], *se = &nodes[node->se];
+
+    uint64_t const inner = nodes[nw->se].population + nodes[ne->sw].population
+                         + nodes[sw->ne].population + nodes[se->nw].population;
+    return inner == node->population;
+}
+
+// same cells in a root twice as wide
+static void Expand(struct HashLife *life)
+{
+    struct Node const root = life->nodes[life->root];
+    uint32_t const e = life->empty[root.level - 1];
+    size_t const kept = life->kept;
+
+    uint32_t const nw = Join(life, e, e, e, root.nw);
+    Keep(life, nw);
+    uint32_t const ne = Join(life, e, e, root.ne, e);
+    Keep(life, ne);
+    uint32_t const sw = Join(life, e, root.sw, e, e);
+    Keep(life, sw);
+    uint32_t const se = Join(life, root.se, e, e, e);
+    Keep(life, se);
+
+    life->root = Join(life, nw, ne, sw, se);
+    life->kept = kept;
+}
+
+static void AdvancePowerOfTwo(struct HashLife *life, int const step)
+{
+    // the centre half must hold everything, then one more level leaves room for the growth
+    while (life->nodes[life->root].level < step + 2 || !BorderEmpty(life, life->root))
+        Expand(life);
+    Expand(life);
+
+    life->root = Successor(life, life->root, step);
+    life->generation += 1ull << step;
+
+    while (life->nodes[life->root].level > 3 && BorderEmpty(life, life->root))
+        life->root = Centre(life, life->root);
+}
+
+void AdvanceHashLife(struct HashLife *life, uint64_t const generations)
+{
+    for (int step = 0; step < 64; ++step) {
+        if (generations >> step & 1) {
+            if (step > MAX_LEVEL - 3) {
+                fprintf(stderr, "hashlife: jump of 2^%d generations is too large\n", step);
+                return;
+            }
+            AdvancePowerOfTwo(life, step);
+        }
+    }
+}
+
+static void Render(struct Node const *nodes, uint32_t const index, long long const x, long long const y,
+                   struct BitGrid *out)
+{
+    struct Node const *node = &nodes[index];
+    long long const size = 1ll << node->level;
+
+    if (node->population == 0 || x >= out->width || y >= out->height || x + size <= 0 || y + size <= 0)
+        return;
+
+    if (node->level == 0) {
+        out->cells[(long)y * out->words + x / 64] |= 1ull << (x % 64);
+        return;
+    }
+
+    long long const half = size / 2;
+    Render(nodes, node->nw, x, y, out);
+    Render(nodes, node->ne, x + half, y, out);
+    Render(nodes, node->sw, x, y + half, out);
+    Render(nodes, node->se, x + half, y + half, out);
+}
+
+void ExtractHashLife(struct HashLife const *life, int64_t const x, int64_t const y, struct BitGrid *out)
+{
+    memset(out->cells, 0, (size_t)out->height * out->words * sizeof *out->cells);
+
+    long long const half = 1ll << (life->nodes[life->root].level - 1);
+    Render(life->nodes, life->root, -half - x, -half - y, out);
+}
+
+uint64_t HashLifeGeneration(struct HashLife const *life)
+{
+    return life->generation;
+}
+
+uint64_t HashLifePopulation(struct HashLife const *life)
+{
+    return life->nodes[life->root].population;
+}
+
+size_t HashLifeNodeCount(struct HashLife const *life)
+{
+    return life->live;
+}
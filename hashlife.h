@@ -0,0 +1,45 @@
+//
+// HashLife : memoized, hash-consed quadtree advancing a Life-like rule by powers of two.
+//
+
+#ifndef GOL_HASHLIFE_H
+#define GOL_HASHLIFE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitlife.h"
+#include "liferule.h"
+
+struct HashLife;
+
+// memory_budget is in bytes, unused nodes and memoized results are collected past it
+struct HashLife * CreateHashLife(size_t memory_budget);
+void FreeHashLife(struct HashLife *life);
+
+// B3/S23 until told otherwise, false for the B0 rules that fill the empty plane
+bool SetHashLifeRule(struct HashLife *life, struct LifeRule rule);
+
+// the board becomes the square [0, width) x [0, height) of an unbounded plane, not a torus
+void LoadHashLifeBits(struct HashLife *life, struct BitGrid const *grid);
+void LoadHashLifeConway(struct HashLife *life, int height, int width, float const (*pixelData)[height][width][2]);
+
+// building block by block like a macrocell file : leaves of 8x8 cells (bit 8 * y + x), then nodes of level 4
+// and up made of 4 nodes one level below, 0 standing for an empty child. Ids are 0 on bad input and stay valid
+// until SetHashLifeRoot, which places the node at (0, 0) and lets unused nodes be collected again.
+uint32_t HashLifeLeaf(struct HashLife *life, uint64_t cells);
+uint32_t HashLifeNode(struct HashLife *life, int level, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+bool SetHashLifeRoot(struct HashLife *life, uint32_t node);
+
+// any count, done as one jump of 2^k generations per bit set
+void AdvanceHashLife(struct HashLife *life, uint64_t generations);
+
+// copies the cells [x, x + out->width) x [y, y + out->height) of the plane into out
+void ExtractHashLife(struct HashLife const *life, int64_t x, int64_t y, struct BitGrid *out);
+
+uint64_t HashLifeGeneration(struct HashLife const *life);
+uint64_t HashLifePopulation(struct HashLife const *life);
+size_t HashLifeNodeCount(struct HashLife const *life);
+
+#endif //GOL_HASHLIFE_H
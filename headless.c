@@ -0,0 +1,722 @@
+//
+// GOL_headless : the engines of GOL without a window, for machines with no display.
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "conway.h"
+#include "wolfram.h"
+#include "smoothlife.h"
+#include "lenia.h"
+#include "ensemble.h"
+#include "pattern.h"
+#include "distributed.h"
+#include "workers.h"
+#include "video.h"
+#include "timing.h"
+
+// the automata that are not Life-like come after the Conway engines
+enum HeadlessEngine {
+    HEADLESS_WOLFRAM = CONWAY_CHUNKS + 1,
+    HEADLESS_SMOOTH,
+    HEADLESS_LENIA,
+};
+
+static struct {
+    char const *name;
+    int engine;
+} const ENGINES[] = {
+    {"float", CONWAY_FLOAT},
+    {"simd", CONWAY_FLOAT_SIMD},
+    {"bits", CONWAY_BITS},
+    {"lut", CONWAY_LUT},
+    {"hashlife", CONWAY_HASHLIFE},
+    {"chunks", CONWAY_CHUNKS},
+    {"wolfram", HEADLESS_WOLFRAM},
+    {"smooth", HEADLESS_SMOOTH},
+    {"lenia", HEADLESS_LENIA},
+};
+
+struct HeadlessRun {
+    char const *program;
+    int engine;
+    uint64_t seed;
+    int threads;
+    uint64_t generations;
+    char const *rule;
+    char const *wolf_rule; // of wolfram, nullptr : the elementary rule of seed
+    struct ConwaySettings settings;
+    char const *ensemble; // results file of the ensemble mode, nullptr : one board
+    char const *seeds;
+    char const *patterns; // files of the ensemble mode, run instead of the seeds
+    char const *rules;
+    char const *sizes;
+    int processes; // strips of the distributed mode, 0 : one board in this process
+    enum HaloTransportKind transport;
+    char const *video; // raw frames of the board, nullptr : none
+    FILE *video_file; // stdout for -
+    enum VideoFormat video_format;
+    uint64_t video_every; // generations between two frames
+    int video_rate;
+};
+
+static void Usage(char const *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --engine NAME           float, simd, bits, lut, hashlife, chunks, wolfram, smooth or lenia (bits)\n"
+            "  --seed N                soup seed, the rule number for wolfram (90)\n"
+            "  --wolf-rule TEXT        wolfram rule as W30, R2/T52 totalistic or R3/B1/S012 outer totalistic\n"
+            "  --width N               (640)\n"
+            "  --height N              (480)\n"
+            "  --generations N         (1000)\n"
+            "  --threads N             0 : every hardware thread (0)\n"
+            "  --rule B/S              Life-like rule (B3/S23)\n"
+            "  --pattern FILE          RLE, macrocell or plaintext instead of a soup\n"
+            "  --hashlife-step N       generations per hashlife step (1)\n"
+            "  --cycle-history N       longest period looked for by bits (4096)\n"
+            "  --temporal-steps N      generations per pass of float and simd, 0 : from the L2 size (0)\n"
+            "  --checkpoint FILE       resumed from, then rewritten every --checkpoint-every generations\n"
+            "  --checkpoint-every N    (1000)\n"
+            "  --video FILE            raw frames of the board, - : stdout, the text goes to stderr then\n"
+            "  --video-format NAME     y4m or ppm, ppm images one after the other (y4m)\n"
+            "  --video-every N         generations between two frames (1)\n"
+            "  --video-fps N           frame rate written in the y4m header (30)\n"
+            "ensemble mode, every seed x rule x size on the bits kernels, one board per worker:\n"
+            "  --ensemble FILE         CSV of the runs, - : stdout\n"
+            "  --seeds LIST            0-99,200 (0-99)\n"
+            "  --patterns LIST         a.rle,b.mc files instead of the seeds, read in parallel, centred on each size\n"
+            "                          and stepped in their own rule unless --rules is given\n"
+            "  --rules LIST            B3/S23,B36/S23 or wolfram rules as W30, W0-255, R2/T0-63 or R3/B1/S012 (--rule)\n"
+            "                          W0-255 with --sizes 1000000 sweeps every elementary rule on wide rows\n"
+            "  --sizes LIST            64,128x96 (--width x --height)\n"
+            "distributed mode, bits, simd or smooth cut in strips of rows, one process each:\n"
+            "  --processes N           strips, 0 : off (0)\n"
+            "  --transport NAME        shm or sockets, for the halo rows (shm)\n",
+            program);
+    exit(EXIT_FAILURE);
+}
+
+static uint64_t ParseCount(char const *program, char const *text)
+{
+    char *end;
+    unsigned long long const value = strtoull(text, &end, 10);
+    if (*text == '\0' || *text == '-' || *end != '\0')
+        Usage(program);
+    return value;
+}
+
+static struct HeadlessRun ParseArguments(int const argc, char **argv)
+{
+    struct HeadlessRun run = {
+        .program = argv[0],
+        .engine = CONWAY_BITS,
+        .seed = 90,
+        .generations = 1000,
+        .rule = "B3/S23",
+        .seeds = "0-99",
+        .video_every = 1,
+        .video_rate = 30,
+        .settings = {
+            .height = 480,
+            .width = 640,
+            .hashlife_step = 1,
+            .hashlife_memory = (size_t)1 << 30,
+            .cycle_history = 4096,
+            .checkpoint_every = 1000,
+        },
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        char const *option = argv[i];
+        if (i + 1 == argc)
+            Usage(argv[0]);
+        char const *value = argv[++i];
+
+        if (strcmp(option, "--engine") == 0) {
+            run.engine = -1;
+            for (size_t e = 0; e < sizeof ENGINES / sizeof *ENGINES; ++e)
+                if (strcmp(value, ENGINES[e].name) == 0)
+                    run.engine = ENGINES[e].engine;
+            if (run.engine < 0)
+                Usage(argv[0]);
+        } else if (strcmp(option, "--seed") == 0) {
+            run.seed = ParseCount(argv[0], value);
+        } else if (strcmp(option, "--width") == 0) {
+            run.settings.width = (int)ParseCount(argv[0], value);
+        } else if (strcmp(option, "--height") == 0) {
+            run.settings.height = (int)ParseCount(argv[0], value);
+        } else if (strcmp(option, "--generations") == 0) {
+            run.generations = ParseCount(argv[0], value);
+        } else if (strcmp(option, "--threads") == 0) {
+            run.threads = (int)ParseCount(argv[0], value);
+        } else if (strcmp(option, "--rule") == 0) {
+            run.rule = value;
+        } else if (strcmp(option, "--wolf-rule") == 0) {
+            run.wolf_rule = value;
+        } else if (strcmp(option, "--pattern") == 0) {
+            run.settings.pattern_file = value;
+        } else if (strcmp(option, "--hashlife-step") == 0) {
+            run.settings.hashlife_step = ParseCount(argv[0], value);
+        } else if (strcmp(option, "--cycle-history") == 0) {
+            run.settings.cycle_history = (int)ParseCount(argv[0], value);
+        } else if (strcmp(option, "--temporal-steps") == 0) {
+            run.settings.temporal_steps = (int)ParseCount(argv[0], value);
+        } else if (strcmp(option, "--checkpoint") == 0) {
+            run.settings.checkpoint_file = value;
+        } else if (strcmp(option, "--checkpoint-every") == 0) {
+            run.settings.checkpoint_every = ParseCount(argv[0], value);
+        } else if (strcmp(option, "--video") == 0) {
+            run.video = value;
+        } else if (strcmp(option, "--video-format") == 0) {
+            if (strcmp(value, "y4m") == 0)
+                run.video_format = VIDEO_Y4M;
+            else if (strcmp(value, "ppm") == 0)
+                run.video_format = VIDEO_PPM;
+            else
+                Usage(argv[0]);
+        } else if (strcmp(option, "--video-every") == 0) {
+            run.video_every = ParseCount(argv[0], value);
+        } else if (strcmp(option, "--video-fps") == 0) {
+            run.video_rate = (int)ParseCount(argv[0], value);
+        } else if (strcmp(option, "--ensemble") == 0) {
+            run.ensemble = value;
+        } else if (strcmp(option, "--seeds") == 0) {
+            run.seeds = value;
+        } else if (strcmp(option, "--patterns") == 0) {
+            run.patterns = value;
+        } else if (strcmp(option, "--rules") == 0) {
+            run.rules = value;
+        } else if (strcmp(option, "--sizes") == 0) {
+            run.sizes = value;
+        } else if (strcmp(option, "--processes") == 0) {
+            run.processes = (int)ParseCount(argv[0], value);
+        } else if (strcmp(option, "--transport") == 0) {
+            if (strcmp(value, "shm") == 0)
+                run.transport = HALO_SHARED_MEMORY;
+            else if (strcmp(value, "sockets") == 0)
+                run.transport = HALO_SOCKETS;
+            else
+                Usage(argv[0]);
+        } else {
+            Usage(argv[0]);
+        }
+    }
+
+    if (run.settings.width <= 0 || run.settings.height <= 0 || run.video_every == 0 || run.video_rate <= 0)
+        Usage(argv[0]);
+    if (run.video != NULL && (run.engine == HEADLESS_WOLFRAM || run.ensemble != NULL || run.processes > 0)) {
+        fprintf(stderr, "--video records the board of one 2D engine\n");
+        exit(EXIT_FAILURE);
+    }
+    // before anything is printed
+    if (run.video != NULL && strcmp(run.video, "-") == 0 && (run.video_file = ClaimStdout()) == NULL) {
+        fprintf(stderr, "fail to take stdout for the video\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!ParseLifeRule(run.rule, &run.settings.rule)) {
+        fprintf(stderr, "not a B/S rule: %s\n", run.rule);
+        exit(EXIT_FAILURE);
+    }
+
+    return run;
+}
+
+// nullptr without --video
+static struct VideoWriter * OpenVideo(struct HeadlessRun const *run, enum VideoSource const source,
+                                      struct VideoPalette const palette)
+{
+    if (run->video == NULL)
+        return NULL;
+    struct VideoSettings const settings = {
+        run->video, run->video_file, run->video_format, source, run->settings.height, run->settings.width,
+        run->video_rate, palette,
+    };
+    struct VideoWriter *video = CreateVideoWriter(&settings);
+    if (video == NULL) {
+        fprintf(stderr, "fail to open the video %s\n", run->video);
+        exit(EXIT_FAILURE);
+    }
+    return video;
+}
+
+static void CloseVideo(struct VideoWriter *video)
+{
+    if (video == NULL)
+        return;
+    struct VideoStats stats;
+    if (!FreeVideoWriter(video, &stats)) {
+        fprintf(stderr, "fail to write the video\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("video %llu frames, %.3f s encoding, %.3f s waited for\n", (unsigned long long)stats.frames,
+           stats.encoding, stats.blocked);
+}
+
+static void QueueConwayFrame(struct VideoWriter *video, struct Conway *conway)
+{
+    struct BitGrid const *bits = ConwayBits(conway);
+    QueueVideoFrame(video, bits != NULL ? (void const *)bits->cells : conway->pixelData);
+}
+
+// returns the generations actually stepped, fewer when the board settled into a cycle
+static uint64_t RunConway(struct HeadlessRun const *run, struct WorkerPool *pool, double *seconds)
+{
+    struct Conway conway;
+    CreateConway(&conway, run->engine, &run->settings, run->seed, pool);
+    uint64_t const first = conway.generation;
+
+    // the palette of LaunchConway
+    struct VideoWriter *video = OpenVideo(run, ConwayBits(&conway) != NULL ? VIDEO_BITS : VIDEO_ALIVE_HEAT,
+                                          ConwayBits(&conway) != NULL
+                                              ? (struct VideoPalette){{0x18, 0x18, 0x18}, {255, 128, 128}}
+                                              : (struct VideoPalette){{0x18, 0x18, 0x18}, {255, 255, 255}});
+
+    double const start = WallSeconds();
+    if (video == NULL) {
+        AdvanceConway(&conway, run->generations);
+    } else {
+        // the writer thread makes the frames, the engine only waits when it is VIDEO_QUEUE of them ahead
+        QueueConwayFrame(video, &conway);
+        for (uint64_t left = run->generations; left > 0 && !conway.settled;) {
+            uint64_t const steps = left < run->video_every ? left : run->video_every;
+            AdvanceConway(&conway, steps);
+            QueueConwayFrame(video, &conway);
+            left -= steps;
+        }
+    }
+    *seconds = WallSeconds() - start;
+    CloseVideo(video);
+
+    printf("generation %llu, population %llu", (unsigned long long)conway.generation,
+           (unsigned long long)ConwayPopulation(&conway));
+    struct BitGrid const *bits = ConwayBits(&conway);
+    if (bits != NULL)
+        printf(", hash %016llx", (unsigned long long)HashBitGrid(bits));
+    printf("\n");
+
+    uint64_t const stepped = conway.generation - first;
+    FreeConway(&conway);
+    return stepped;
+}
+
+static uint64_t RunWolfram(struct HeadlessRun const *run, double *seconds)
+{
+    struct WolfRow row = CreateWolfRow(run->settings.width);
+    struct WolfRow next = CreateWolfRow(run->settings.width);
+    if (row.cells == NULL || next.cells == NULL) {
+        fprintf(stderr, "fail to allocate the row\n");
+        exit(EXIT_FAILURE);
+    }
+    if (run->wolf_rule == NULL && run->seed > 255) {
+        fprintf(stderr, "the elementary rules go from 0 to 255, not %llu\n", (unsigned long long)run->seed);
+        exit(EXIT_FAILURE);
+    }
+    struct WolfRule rule = WOLF_ELEMENTARY_RULE((unsigned char)run->seed);
+    if (run->wolf_rule != NULL && !ParseWolfRule(run->wolf_rule, &rule)) {
+        fprintf(stderr, "not a wolfram rule: %s\n", run->wolf_rule);
+        exit(EXIT_FAILURE);
+    }
+    struct WolfKernel const kernel = SelectWolfKernel(rule);
+    InitWolfRow(&row);
+
+    // 64 cells per word, no history kept, --height does not matter
+    uint64_t population = CountWolfRow(&row);
+    double const start = WallSeconds();
+    for (uint64_t i = 0; i < run->generations; ++i) {
+        population = StepWolfKernel(&kernel, &row, &next);
+        struct WolfRow const swap = row;
+        row = next;
+        next = swap;
+    }
+    *seconds = WallSeconds() - start;
+
+    char text[32];
+    FormatWolfRule(rule, text);
+    printf("rule %s, %s kernel, last row population %llu, hash %016llx\n", text, kernel.name,
+           (unsigned long long)population, (unsigned long long)HashWolfRow(&row));
+
+    FreeWolfRow(&row);
+    FreeWolfRow(&next);
+    return run->generations;
+}
+
+static double FieldMass(int const height, int const width, float const (*field)[height][width])
+{
+    double mass = 0;
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            mass += (*field)[y][x];
+    return mass;
+}
+
+static uint64_t RunField(struct HeadlessRun const *run, struct WorkerPool *pool, double *seconds)
+{
+    int const height = run->settings.height, width = run->settings.width;
+    float (*pixelData)[height][width] = malloc(sizeof *pixelData);
+    float (*newPixelData)[height][width] = malloc(sizeof *newPixelData);
+    float (*convolvedData)[height][width] = run->engine == HEADLESS_LENIA ? malloc(sizeof *convolvedData) : NULL;
+    if (pixelData == NULL || newPixelData == NULL || (run->engine == HEADLESS_LENIA && convolvedData == NULL)) {
+        fprintf(stderr, "fail to allocate the board\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (run->engine == HEADLESS_LENIA) {
+        InitKernel(128);
+        InitLenia(height, width, pixelData, run->seed);
+    } else {
+        InitSmoothworld(height, width, pixelData, run->seed, pool);
+    }
+
+    // the palettes of LaunchLenia and LaunchSmoothWorld
+    struct VideoWriter *video = OpenVideo(run, VIDEO_INTENSITY, run->engine == HEADLESS_LENIA
+                                              ? (struct VideoPalette){{0, 0, 0}, {255, 255, 255}}
+                                              : (struct VideoPalette){{0x18, 0x18, 0x18}, {255, 0x18, 0x18}});
+    if (video != NULL)
+        QueueVideoFrame(video, pixelData);
+
+    double const start = WallSeconds();
+    for (uint64_t i = 0; i < run->generations; ++i) {
+        if (run->engine == HEADLESS_LENIA) {
+            Convolve(height, width, pixelData, convolvedData);
+            ApplyGrowth(height, width, convolvedData, newPixelData);
+        } else {
+            StepSmoothWorld(height, width, pixelData, newPixelData, pool);
+        }
+
+        void *tmp = pixelData;
+        pixelData = newPixelData;
+        newPixelData = tmp;
+
+        if (video != NULL && ((i + 1) % run->video_every == 0 || i + 1 == run->generations))
+            QueueVideoFrame(video, pixelData);
+    }
+    *seconds = WallSeconds() - start;
+    CloseVideo(video);
+
+    printf("mass %.3f\n", FieldMass(height, width, pixelData));
+
+    free(pixelData);
+    free(newPixelData);
+    free(convolvedData);
+    return run->generations;
+}
+
+// the items of a comma separated list, one at a time
+static bool NextItem(char const **list, char item[static 64])
+{
+    if (*list == NULL || **list == '\0')
+        return false;
+    size_t const length = strcspn(*list, ",");
+    if (length >= 64)
+        return false;
+    memcpy(item, *list, length);
+    item[length] = '\0';
+    *list = (*list)[length] == ',' ? *list + length + 1 : NULL;
+    return true;
+}
+
+// "7" or "0-255"
+static bool ParseRange(char const *text, uint64_t *first, uint64_t *last)
+{
+    char *end;
+    if (*text < '0' || *text > '9')
+        return false;
+    *first = *last = strtoull(text, &end, 10);
+    if (*end == '-') {
+        text = end + 1;
+        if (*text < '0' || *text > '9')
+            return false;
+        *last = strtoull(text, &end, 10);
+    }
+    return *end == '\0' && *first <= *last;
+}
+
+struct EnsembleOutput {
+    FILE *file;
+    struct PatternJob const *patterns; // the seed of a pattern run is its position in them
+};
+
+static void WriteEnsembleResult(void *context, size_t const index, struct EnsembleRun const *run,
+                                struct EnsembleResult const *result)
+{
+    struct EnsembleOutput *output = context;
+    char rule[32];
+    if (run->wolfram)
+        FormatWolfRule(run->wolfram_rule, rule);
+    else
+        FormatLifeRule(run->rule, rule);
+
+    // one call per line, stdio keeps the lines of the workers whole
+    fprintf(output->file, "%zu,%s,%d,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%016llx,%.6f,%s\n",
+            index, rule, run->width, run->height, (unsigned long long)run->seed,
+            (unsigned long long)result->generations, (unsigned long long)result->initial_population,
+            (unsigned long long)result->population, (unsigned long long)result->min_population,
+            (unsigned long long)result->max_population, (unsigned long long)result->period,
+            (unsigned long long)result->cycle_start, (unsigned long long)result->hash, result->seconds,
+            run->pattern != NULL ? output->patterns[run->seed].path : "");
+}
+
+// the files of --patterns, read on the workers of pool at once; list keeps the paths, one that fails ends the program
+static struct PatternJob * LoadEnsemblePatterns(char const *patterns, struct WorkerPool *pool, char **list, int *count)
+{
+    *list = strdup(patterns);
+    int capacity = 1;
+    for (char const *c = patterns; *c != '\0'; ++c)
+        capacity += *c == ',';
+    struct PatternJob *jobs = calloc(capacity, sizeof *jobs);
+    if (*list == NULL || jobs == NULL) {
+        fprintf(stderr, "fail to allocate the patterns\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *count = 0;
+    for (char *path = *list; path != NULL; ++*count) {
+        char *comma = strchr(path, ',');
+        if (comma != NULL)
+            *comma = '\0';
+        jobs[*count].path = path;
+        path = comma != NULL ? comma + 1 : NULL;
+    }
+
+    double const start = WallSeconds();
+    LoadPatternJobs(jobs, *count, pool);
+    for (int i = 0; i < *count; ++i) {
+        if (!jobs[i].ok) {
+            fprintf(stderr, "fail to read the pattern %s\n", jobs[i].path);
+            exit(EXIT_FAILURE);
+        }
+    }
+    fprintf(stderr, "%d patterns read in %.3f s\n", *count, WallSeconds() - start);
+    return jobs;
+}
+
+static void RunEnsembleMode(struct HeadlessRun const *run, struct WorkerPool *pool)
+{
+    char *pattern_list = NULL;
+    int pattern_count = 0;
+    struct PatternJob *patterns = NULL;
+    if (run->patterns != NULL)
+        patterns = LoadEnsemblePatterns(run->patterns, pool, &pattern_list, &pattern_count);
+
+    char default_size[64];
+    sprintf(default_size, "%dx%d", run->settings.width, run->settings.height);
+
+    // seeds x rules x sizes, a wolfram rule once per size
+    struct EnsembleRun *runs = NULL;
+    size_t count = 0, capacity = 0;
+    char item[64];
+    char const *sizes = run->sizes != NULL ? run->sizes : default_size;
+    while (NextItem(&sizes, item)) {
+        int width, height;
+        char *end;
+        width = height = (int)strtol(item, &end, 10);
+        if (*end == 'x')
+            height = (int)strtol(end + 1, &end, 10);
+        if (*end != '\0' || width <= 0 || height <= 0)
+            Usage(run->program);
+
+        char const *rules = run->rules != NULL ? run->rules : run->rule;
+        char rule_text[64];
+        while (NextItem(&rules, rule_text)) {
+            struct EnsembleRun model = {.width = width, .height = height};
+            uint64_t first, last;
+            bool const wolfram = rule_text[0] == 'W' || rule_text[0] == 'R';
+            if (wolfram) {
+                // a range of codes after W or /T, one run each; an outer totalistic rule is a single one
+                char *codes = rule_text[0] == 'W' ? rule_text + 1 : strstr(rule_text, "/T");
+                if (codes != NULL && rule_text[0] == 'R')
+                    codes += 2;
+                if (codes != NULL) {
+                    if (!ParseRange(codes, &first, &last))
+                        Usage(run->program);
+                    sprintf(codes, "%llu", (unsigned long long)last); // the largest code checked below
+                }
+                if (!ParseWolfRule(rule_text, &model.wolfram_rule)) {
+                    fprintf(stderr, "not a wolfram rule: %s\n", rule_text);
+                    exit(EXIT_FAILURE);
+                }
+                if (codes == NULL)
+                    first = last = model.wolfram_rule.birth;
+                model.wolfram = true;
+            } else {
+                if (!ParseLifeRule(rule_text, &model.rule)) {
+                    fprintf(stderr, "not a B/S rule: %s\n", rule_text);
+                    exit(EXIT_FAILURE);
+                }
+                first = last = 0;
+            }
+
+            // each pattern once per rule and size, in place of the seeds
+            for (int p = 0; !wolfram && p < pattern_count; ++p) {
+                if (count == capacity) {
+                    capacity = capacity ? capacity * 2 : 1024;
+                    runs = realloc(runs, capacity * sizeof *runs);
+                    if (runs == NULL) {
+                        fprintf(stderr, "fail to allocate the ensemble\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                runs[count] = model;
+                runs[count].seed = (uint64_t)p;
+                runs[count].pattern = &patterns[p].grid;
+                if (run->rules == NULL && patterns[p].info.has_rule)
+                    runs[count].rule = patterns[p].info.rule;
+                count++;
+            }
+
+            for (uint64_t r = first; r <= last && (wolfram || patterns == NULL); ++r) {
+                char const *seeds = run->seeds;
+                char seed_text[64];
+                while (NextItem(&seeds, seed_text)) {
+                    uint64_t seed_first, seed_last;
+                    if (!ParseRange(seed_text, &seed_first, &seed_last))
+                        Usage(run->program);
+                    // a wolfram automaton starts from one cell whatever the seed
+                    if (wolfram)
+                        seed_last = seed_first;
+
+                    for (uint64_t seed = seed_first; seed <= seed_last; ++seed) {
+                        if (count == capacity) {
+                            capacity = capacity ? capacity * 2 : 1024;
+                            runs = realloc(runs, capacity * sizeof *runs);
+                            if (runs == NULL) {
+                                fprintf(stderr, "fail to allocate the ensemble\n");
+                                exit(EXIT_FAILURE);
+                            }
+                        }
+                        runs[count] = model;
+                        runs[count].seed = seed;
+                        runs[count].wolfram_rule.birth = (uint16_t)r;
+                        count++;
+                    }
+                    if (wolfram)
+                        break;
+                }
+            }
+        }
+    }
+
+    struct EnsembleOutput output = {strcmp(run->ensemble, "-") == 0 ? stdout : fopen(run->ensemble, "w"), patterns};
+    if (output.file == NULL) {
+        fprintf(stderr, "fail to open %s\n", run->ensemble);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(output.file, "run,rule,width,height,seed,generations,initial_population,population,"
+                         "min_population,max_population,period,cycle_start,hash,seconds,pattern\n");
+
+    struct EnsembleSettings const settings = {run->generations, run->settings.cycle_history};
+    fprintf(stderr, "%zu simulations on %d workers\n", count, WorkerCount(pool));
+    double const start = WallSeconds();
+    bool const ok = RunEnsemble(runs, count, &settings, pool, WriteEnsembleResult, &output);
+    double const seconds = WallSeconds() - start;
+
+    if (output.file != stdout)
+        fclose(output.file);
+    free(runs);
+    FreePatternJobs(patterns, pattern_count);
+    free(patterns);
+    free(pattern_list);
+    if (!ok) {
+        fprintf(stderr, "fail to allocate some of the boards\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(stderr, "%zu simulations in %.3f s, %.0f simulations/hour\n", count, seconds,
+            seconds > 0 ? count / seconds * 3600 : 0);
+}
+
+static void RunDistributedMode(struct HeadlessRun const *run)
+{
+    struct DistributedSettings settings = {
+        .transport = run->transport,
+        .processes = run->processes,
+        .height = run->settings.height,
+        .width = run->settings.width,
+        .rule = run->settings.rule,
+        .seed = run->seed,
+        .generations = run->generations,
+    };
+    if (run->engine == CONWAY_BITS)
+        settings.engine = DISTRIBUTED_BITS;
+    else if (run->engine == CONWAY_FLOAT_SIMD)
+        settings.engine = DISTRIBUTED_FLOAT;
+    else if (run->engine == HEADLESS_SMOOTH)
+        settings.engine = DISTRIBUTED_SMOOTH;
+    else
+        Usage(run->program);
+    if (run->processes > run->settings.height) {
+        fprintf(stderr, "more processes than rows\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%d processes over %s, %dx%d, seed %llu\n", run->processes,
+           run->transport == HALO_SOCKETS ? "sockets" : "shared memory", run->settings.width,
+           run->settings.height, (unsigned long long)run->seed);
+
+    struct DistributedResult result;
+    if (!RunDistributed(&settings, &result)) {
+        fprintf(stderr, "fail to run the processes\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double const cells = (double)run->generations * run->settings.width * run->settings.height;
+    printf("generation %llu, population %llu, hash %016llx\n", (unsigned long long)run->generations,
+           (unsigned long long)result.population, (unsigned long long)result.hash);
+    printf("%llu generations in %.3f s, %.1f generations/s, %.3g cells/s\n",
+           (unsigned long long)run->generations, result.seconds,
+           result.seconds > 0 ? run->generations / result.seconds : 0,
+           result.seconds > 0 ? cells / result.seconds : 0);
+}
+
+int main(int argc, char **argv)
+{
+    struct HeadlessRun const run = ParseArguments(argc, argv);
+
+    // before the pool, the forked processes do not need its threads
+    if (run.processes > 0) {
+        RunDistributedMode(&run);
+        exit(EXIT_SUCCESS);
+    }
+
+    struct WorkerPool *pool = CreateWorkerPool(run.threads);
+    if (pool == NULL) {
+        fprintf(stderr, "fail to start the worker pool\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (run.ensemble != NULL) {
+        RunEnsembleMode(&run, pool);
+        FreeWorkerPool(pool);
+        exit(EXIT_SUCCESS);
+    }
+
+    char const *name = "";
+    for (size_t e = 0; e < sizeof ENGINES / sizeof *ENGINES; ++e)
+        if (ENGINES[e].engine == run.engine)
+            name = ENGINES[e].name;
+    printf("engine %s, %dx%d, seed %llu, %d workers\n", name, run.settings.width, run.settings.height,
+           (unsigned long long)run.seed, WorkerCount(pool));
+
+    double seconds = 0;
+    uint64_t generations;
+    if (run.engine == HEADLESS_WOLFRAM)
+        generations = RunWolfram(&run, &seconds);
+    else if (run.engine == HEADLESS_SMOOTH || run.engine == HEADLESS_LENIA)
+        generations = RunField(&run, pool, &seconds);
+    else
+        generations = RunConway(&run, pool, &seconds);
+
+    // a wolfram generation is one row
+    double const cells = (double)generations * run.settings.width
+                         * (run.engine == HEADLESS_WOLFRAM ? 1 : run.settings.height);
+    printf("%llu generations in %.3f s, %.1f generations/s, %.3g cells/s\n", (unsigned long long)generations,
+           seconds, seconds > 0 ? generations / seconds : 0, seconds > 0 ? cells / seconds : 0);
+
+    FreeWorkerPool(pool);
+    exit(EXIT_SUCCESS);
+}
@@ -4,13 +4,24 @@
 #include <math.h>
 #include <stdbool.h>
 
+#ifndef GOL_HEADLESS
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "util_glfw.h"
+#include "simulation.h"
+#endif
+#include "lenia.h"
+#include "checkpoint.h"
+#include "rng.h"
 
+static float TIME_STEP = 0.1f;
+#ifndef GOL_HEADLESS
 static int WIDTH = 800;
 static int HEIGHT = 600;
-static float TIME_STEP = 0.1f;
+static char const *CHECKPOINT_FILE = NULL; // resumed from when it matches the board, rewritten every CHECKPOINT_EVERY steps
+static uint64_t CHECKPOINT_EVERY = 100; // 0 : resume only
+static double GENERATIONS_PER_SECOND = 0; // of the simulation thread, 0 : as fast as it goes whatever the refresh rate
+#endif
 
 // Gaussian kernel for convolution
 float kernel[128][128]; // Example size; can be adjusted
@@ -75,34 +86,98 @@ void ApplyGrowth(
     }
 }
 
+void InitLenia(int height, int width, float (*pixelData)[height][width], uint64_t seed) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint64_t const bits = RandomAt(seed, (uint64_t)y << 32 | (uint64_t)x);
+            (*pixelData)[y][x] = (float)(bits % 100) / 100.0f; // Random initial state
+        }
+    }
+}
+
+#ifndef GOL_HEADLESS
+// owned by the simulation thread until StopSimulation
+struct LeniaRun {
+    void *pixelData; // float[HEIGHT][WIDTH]
+    void *newPixelData;
+    void *convolvedData;
+    uint64_t generation;
+    uint64_t last_checkpoint;
+    struct CheckpointHeader header;
+    struct CheckpointWriter *checkpoints;
+};
+
+static bool StepLeniaRun(void *context)
+{
+    struct LeniaRun *run = context;
+
+    // Apply Lenia dynamics
+    Convolve(HEIGHT, WIDTH, run->pixelData, run->convolvedData);
+    ApplyGrowth(HEIGHT, WIDTH, run->convolvedData, run->newPixelData);
+
+    memcpy(run->pixelData, run->newPixelData, sizeof(float[HEIGHT][WIDTH]));
+    run->generation++;
+
+    if (run->checkpoints != NULL && run->generation - run->last_checkpoint >= CHECKPOINT_EVERY) {
+        run->header.generation = run->generation;
+        if (QueueCheckpoint(run->checkpoints, CHECKPOINT_FILE, &run->header, run->pixelData))
+            run->last_checkpoint = run->generation;
+    }
+    return true;
+}
+
+static void PublishLeniaRun(void *context, void *frame)
+{
+    struct LeniaRun const *run = context;
+    ConvertIntensityToTexels(HEIGHT, WIDTH, run->pixelData, frame);
+}
+
 // Launch function for Lenia
 void LaunchLenia(unsigned char seed) {
-    float (*pixelColors)[HEIGHT * WIDTH * 3] = malloc(sizeof(float[HEIGHT * WIDTH * 3]));
     float (*pixelData)[HEIGHT][WIDTH] = malloc(sizeof(float[HEIGHT][WIDTH]));
     float (*newPixelData)[HEIGHT][WIDTH] = malloc(sizeof(float[HEIGHT][WIDTH]));
     float (*convolvedData)[HEIGHT][WIDTH] = malloc(sizeof(float[HEIGHT][WIDTH]));
 
-    if (pixelColors == NULL || pixelData == NULL || newPixelData == NULL || convolvedData == NULL) {
+    if (pixelData == NULL || newPixelData == NULL || convolvedData == NULL) {
         fprintf(stderr, "Failed to allocate memory\n");
         exit(EXIT_FAILURE);
     }
 
-    srand(seed);
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            (*pixelData)[y][x] = (float)(rand() % 100) / 100.0f; // Random initial state
+    InitLenia(HEIGHT, WIDTH, pixelData, seed);
+
+    uint64_t generation = 0, last_checkpoint = 0;
+    struct CheckpointHeader header = MakeCheckpointHeader(CHECKPOINT_LENIA, HEIGHT, WIDTH, sizeof(float[HEIGHT][WIDTH]));
+    header.rng_seed = seed;
+    struct CheckpointWriter *checkpoints = NULL;
+    if (CHECKPOINT_FILE != NULL) {
+        struct Checkpoint resume;
+        if (OpenCheckpoint(CHECKPOINT_FILE, &resume)) {
+            if (resume.header.kind == CHECKPOINT_LENIA && resume.header.raw_size == header.raw_size
+                && resume.header.height == HEIGHT && resume.header.width == WIDTH) {
+                memcpy(pixelData, resume.payload, header.raw_size);
+                generation = last_checkpoint = resume.header.generation;
+                printf("resumed %s at step %llu\n", CHECKPOINT_FILE, (unsigned long long)generation);
+            }
+            CloseCheckpoint(&resume);
+        }
+        if (CHECKPOINT_EVERY != 0 && (checkpoints = CreateCheckpointWriter()) == NULL) {
+            fprintf(stderr, "Failed to start the checkpoint writer\n");
+            exit(EXIT_FAILURE);
         }
     }
 
     InitKernel(128); // Initialize the Gaussian kernel
 
     GLFWwindow *window = OpenWindow("Lenia", WIDTH, HEIGHT, false, true);
-    GLuint program, VAO, VBO;
-    GLint vpos_location, vcol_location;
+    struct StateView view;
+    CreateStateView(&view, STATE_INTENSITY, HEIGHT, WIDTH, (struct StatePalette){{0, 0, 0}, {1, 1, 1}});
 
-    LoadShaders(&program, &vpos_location, &vcol_location);
-
-    long offset = GeneratePixelData(HEIGHT, WIDTH, pixelColors, vpos_location, vcol_location, &VAO, &VBO);
+    struct LeniaRun run = {pixelData, newPixelData, convolvedData, generation, last_checkpoint, header, checkpoints};
+    struct SimulationThread simulation;
+    if (!StartSimulation(&simulation, view.size, GENERATIONS_PER_SECOND, StepLeniaRun, PublishLeniaRun, &run)) {
+        fprintf(stderr, "Failed to start the simulation thread\n");
+        exit(EXIT_FAILURE);
+    }
 
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
@@ -113,27 +188,26 @@ void LaunchLenia(unsigned char seed) {
         glViewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Apply Lenia dynamics
-        Convolve(HEIGHT, WIDTH, pixelData, convolvedData);
-        ApplyGrowth(HEIGHT, WIDTH, convolvedData, newPixelData);
-
-        int k = 0;
-        for (int i = 0; i < HEIGHT * WIDTH; ++i) {
-            float intensity = (*newPixelData)[i / WIDTH][i % WIDTH];
-            (*pixelColors)[k++] = intensity; // R
-            (*pixelColors)[k++] = intensity; // G
-            (*pixelColors)[k++] = intensity; // B
-        }
-
-        memcpy(pixelData, newPixelData, sizeof(float[HEIGHT][WIDTH]));
-
-        RenderPixels(WIDTH * HEIGHT, program, VAO, HEIGHT, WIDTH, offset, pixelColors);
+        bool fresh;
+        void const *frame = LatestSimulationFrame(&simulation, &fresh);
+        if (fresh)
+            UploadStateView(&view, frame);
+        DrawStateView(&view);
+        PrintStateUploads(&view);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    free(pixelColors);
+    StopSimulation(&simulation);
+    if (checkpoints != NULL) {
+        FreeCheckpointWriter(checkpoints);
+        run.header.generation = run.generation;
+        if (run.generation != run.last_checkpoint && !WriteCheckpoint(CHECKPOINT_FILE, &run.header, pixelData))
+            fprintf(stderr, "Failed to write the checkpoint %s\n", CHECKPOINT_FILE);
+    }
+
+    FreeStateView(&view);
     free(pixelData);
     free(newPixelData);
     free(convolvedData);
@@ -141,3 +215,4 @@ void LaunchLenia(unsigned char seed) {
     glfwDestroyWindow(window);
     glfwTerminate();
 }
+#endif
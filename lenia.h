@@ -5,7 +5,15 @@
 #ifndef GOL_LENIA_H
 #define GOL_LENIA_H
 
-int LaunchLenia(unsigned char seed);
+#include <stdint.h>
+
+void LaunchLenia(unsigned char seed);
+
+// the gaussian kernel, size x size, once before stepping
+void InitKernel(int size);
+void InitLenia(int height, int width, float (*pixelData)[height][width], uint64_t seed);
+void Convolve(int height, int width, float (*input)[height][width], float (*output)[height][width]);
+void ApplyGrowth(int height, int width, float (*input)[height][width], float (*output)[height][width]);
 
 
 #endif //GOL_LENIA_H
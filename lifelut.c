@@ -0,0 +1,138 @@
+#include "lifelut.h"
+
+void BuildLifeLut(struct LifeLut *lut, struct LifeRule const rule)
+{
+    lut->rule = rule;
+
+    for (unsigned index = 0; index < 1 << 9; ++index) {
+        bool const alive = index >> 4 & 1;
+        int const neighbours = PopCount64(index & ~(1u << 4));
+        lut->cell[index] = LifeRuleNext(rule, alive, neighbours);
+    }
+
+    for (unsigned index = 0; index < 1 << 16; ++index) {
+        uint8_t next = 0;
+        for (int i = 0; i < 4; ++i) {
+            int const cx = 1 + (i & 1), cy = 1 + (i >> 1);
+            int neighbours = 0;
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                    if (dx || dy)
+                        neighbours += index >> (4 * (cy + dy) + cx + dx) & 1;
+            bool const alive = index >> (4 * cy + cx) & 1;
+            next |= LifeRuleNext(rule, alive, neighbours) << i;
+        }
+        lut->block[index] = next;
+    }
+}
+
+// cells x-1 .. x+64 around the word holding x = 64 * j, as the bits 0..65 of lo | hi << 64
+static inline void ExtendedWord(uint64_t const *row, int const j, int const words, int const width,
+                                uint64_t *lo, uint64_t *hi)
+{
+    int const valid = j < words - 1 ? 64 : width - 64 * j;
+    uint64_t const west = j > 0 ? row[j - 1] >> 63 : row[words - 1] >> ((width - 1) % 64) & 1;
+    uint64_t const east = j < words - 1 ? row[j + 1] & 1 : row[0] & 1;
+
+    *lo = row[j] << 1 | west;
+    *hi = row[j] >> 63;
+
+    // east lands right after the last valid cell
+    if (valid + 1 < 64)
+        *lo |= east << (valid + 1);
+    else
+        *hi |= east << (valid + 1 - 64);
+}
+
+static inline unsigned Bits3(uint64_t const lo, uint64_t const hi, int const i)
+{
+    return (unsigned)(i < 62 ? lo >> i : lo >> i | hi << (64 - i)) & 7;
+}
+
+static inline unsigned Bits4(uint64_t const lo, uint64_t const hi, int const i)
+{
+    return (unsigned)(i < 61 ? lo >> i : lo >> i | hi << (64 - i)) & 15;
+}
+
+static inline uint64_t LastMask(struct BitGrid const *grid, int const j)
+{
+    return j == grid->words - 1 && grid->width % 64 ? ~0ull >> (64 - grid->width % 64) : ~0ull;
+}
+
+void IterateBitLifeLut3Rows(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid,
+                            int const begin, int const end)
+{
+    int const height = grid->height, width = grid->width, words = grid->words;
+
+    for (int y = begin; y < end; ++y) {
+        uint64_t const *rows[3] = {
+                grid->cells + (long)(y == 0 ? height - 1 : y - 1) * words,
+                grid->cells + (long)y * words,
+                grid->cells + (long)(y == height - 1 ? 0 : y + 1) * words,
+        };
+
+        for (int j = 0; j < words; ++j) {
+            uint64_t lo[3], hi[3];
+            for (int r = 0; r < 3; ++r)
+                ExtendedWord(rows[r], j, words, width, &lo[r], &hi[r]);
+
+            uint64_t next = 0;
+            for (int i = 0; i < 64; ++i) {
+                unsigned const index = Bits3(lo[0], hi[0], i)
+                                     | Bits3(lo[1], hi[1], i) << 3
+                                     | Bits3(lo[2], hi[2], i) << 6;
+                next |= (uint64_t)lut->cell[index] << i;
+            }
+            newGrid->cells[(long)y * words + j] = next & LastMask(grid, j);
+        }
+    }
+}
+
+void IterateBitLifeLut3(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid)
+{
+    IterateBitLifeLut3Rows(lut, grid, newGrid, 0, grid->height);
+}
+
+void IterateBitLifeLut4Pairs(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid,
+                             int const begin, int const end)
+{
+    int const height = grid->height, width = grid->width, words = grid->words;
+
+    for (int pair = begin; pair < end; ++pair) {
+        int const y = 2 * pair;
+        // an odd last row is paired with a row that wraps around and is thrown away
+        uint64_t const *rows[4] = {
+                grid->cells + (long)((y + height - 1) % height) * words,
+                grid->cells + (long)y * words,
+                grid->cells + (long)((y + 1) % height) * words,
+                grid->cells + (long)((y + 2) % height) * words,
+        };
+
+        for (int j = 0; j < words; ++j) {
+            uint64_t lo[4], hi[4];
+            for (int r = 0; r < 4; ++r)
+                ExtendedWord(rows[r], j, words, width, &lo[r], &hi[r]);
+
+            uint64_t top = 0, bottom = 0;
+            for (int i = 0; i < 64; i += 2) {
+                unsigned const index = Bits4(lo[0], hi[0], i)
+                                     | Bits4(lo[1], hi[1], i) << 4
+                                     | Bits4(lo[2], hi[2], i) << 8
+                                     | Bits4(lo[3], hi[3], i) << 12;
+                uint64_t const block = lut->block[index];
+                top |= (block & 3) << i;
+                bottom |= (block >> 2) << i;
+            }
+
+            uint64_t const mask = LastMask(grid, j);
+            newGrid->cells[(long)y * words + j] = top & mask;
+            if (y + 1 < height)
+                newGrid->cells[(long)(y + 1) * words + j] = bottom & mask;
+        }
+    }
+}
+
+void IterateBitLifeLut4(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid)
+{
+    IterateBitLifeLut4Pairs(lut, grid, newGrid, 0, (grid->height + 1) / 2);
+}
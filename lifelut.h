@@ -0,0 +1,33 @@
+//
+// Table driven Life-like kernels on a BitGrid, tables built from any rule at startup.
+//
+
+#ifndef GOL_LIFELUT_H
+#define GOL_LIFELUT_H
+
+#include <stdint.h>
+
+#include "bitlife.h"
+#include "liferule.h"
+
+struct LifeLut {
+    struct LifeRule rule;
+    // 3x3 block, bit 3 * y + x, gives the centre cell
+    uint8_t cell[1 << 9];
+    // 4x4 block, bit 4 * y + x, gives the 2x2 centre : top pair in bits 0-1, bottom pair in bits 2-3
+    uint8_t block[1 << 16];
+};
+
+void BuildLifeLut(struct LifeLut *lut, struct LifeRule rule);
+
+// one lookup per cell in the 512 entry table
+void IterateBitLifeLut3(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid);
+void IterateBitLifeLut3Rows(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid,
+                            int begin, int end);
+
+// one lookup per 2x2 block in the 65536 entry table, bands are counted in pairs of rows
+void IterateBitLifeLut4(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid);
+void IterateBitLifeLut4Pairs(struct LifeLut const *lut, struct BitGrid const *grid, struct BitGrid *newGrid,
+                             int begin, int end);
+
+#endif //GOL_LIFELUT_H
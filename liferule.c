@@ -0,0 +1,59 @@
+#include <ctype.h>
+
+#include "liferule.h"
+
+// digits 0 to 8 until the first character that is not one, returns where it stopped
+static char const * ParseCounts(char const *text, uint16_t *counts)
+{
+    *counts = 0;
+    for (; *text >= '0' && *text <= '8'; ++text)
+        *counts |= 1 << (*text - '0');
+    return text;
+}
+
+bool ParseLifeRule(char const *text, struct LifeRule *rule)
+{
+    struct LifeRule parsed = {0};
+
+    while (isspace((unsigned char)*text))
+        ++text;
+
+    if (tolower((unsigned char)*text) == 'b') {
+        text = ParseCounts(text + 1, &parsed.birth);
+        if (*text == '/')
+            ++text;
+        if (tolower((unsigned char)*text) != 's')
+            return false;
+        text = ParseCounts(text + 1, &parsed.survival);
+    } else {
+        // S/B, the notation of the old Life programs
+        text = ParseCounts(text, &parsed.survival);
+        if (*text != '/')
+            return false;
+        text = ParseCounts(text + 1, &parsed.birth);
+    }
+
+    while (isspace((unsigned char)*text))
+        ++text;
+    if (*text != '\0')
+        return false;
+
+    *rule = parsed;
+    return true;
+}
+
+void FormatLifeRule(struct LifeRule const rule, char text[static 24])
+{
+    int k = 0;
+
+    text[k++] = 'B';
+    for (int n = 0; n <= 8; ++n)
+        if (rule.birth >> n & 1)
+            text[k++] = (char)('0' + n);
+    text[k++] = '/';
+    text[k++] = 'S';
+    for (int n = 0; n <= 8; ++n)
+        if (rule.survival >> n & 1)
+            text[k++] = (char)('0' + n);
+    text[k] = '\0';
+}
@@ -0,0 +1,40 @@
+//
+// Life-like rules : which neighbour counts give birth and which keep a cell alive.
+//
+
+#ifndef GOL_LIFERULE_H
+#define GOL_LIFERULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// bit n set when n living neighbours (0 to 8) give birth / let a living cell survive
+struct LifeRule {
+    uint16_t birth;
+    uint16_t survival;
+};
+
+#define CONWAY_LIFE_RULE ((struct LifeRule){.birth = 1 << 3, .survival = 1 << 2 | 1 << 3})
+
+// the rules the engines compile a kernel of their own for, X(name, birth, survival)
+#define SPECIALISED_RULES(X) \
+    X(Conway, 1 << 3, 1 << 2 | 1 << 3) \
+    X(HighLife, 1 << 3 | 1 << 6, 1 << 2 | 1 << 3) \
+    X(Seeds, 1 << 2, 0) \
+    X(DayAndNight, 1 << 3 | 1 << 6 | 1 << 7 | 1 << 8, 1 << 3 | 1 << 4 | 1 << 6 | 1 << 7 | 1 << 8) \
+    X(LifeWithoutDeath, 1 << 3, 0x1ff) \
+    X(Maze, 1 << 3, 1 << 1 | 1 << 2 | 1 << 3 | 1 << 4 | 1 << 5) \
+    X(TwoByTwo, 1 << 3 | 1 << 6, 1 << 1 | 1 << 2 | 1 << 5) \
+    X(Replicator, 1 << 1 | 1 << 3 | 1 << 5 | 1 << 7, 1 << 1 | 1 << 3 | 1 << 5 | 1 << 7)
+
+// "B3/S23", "b36/s23", "B3S23" or the older survival first "23/3", false when the text is not a rule
+bool ParseLifeRule(char const *text, struct LifeRule *rule);
+// canonical "B3/S23" form, 22 characters at most
+void FormatLifeRule(struct LifeRule rule, char text[static 24]);
+
+static inline bool LifeRuleNext(struct LifeRule const rule, bool const alive, int const neighbours)
+{
+    return ((alive ? rule.survival : rule.birth) >> neighbours) & 1;
+}
+
+#endif //GOL_LIFERULE_H
@@ -0,0 +1,61 @@
+//
+// Next generation of 64 cells at once from the 9 words around them, shared by the bit-packed engines.
+//
+
+#ifndef GOL_LIFEWORD_H
+#define GOL_LIFEWORD_H
+
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define RULE_INLINE static inline __attribute__((always_inline))
+#else
+#define RULE_INLINE static inline
+#endif
+
+#define CONWAY_BIRTH (1 << 3)
+#define CONWAY_SURVIVAL (1 << 2 | 1 << 3)
+
+// the 64 cells whose neighbour count t3 t2 t1 t0 is n
+RULE_INLINE uint64_t CountIs(uint64_t const t0, uint64_t const t1, uint64_t const t2, uint64_t const t3, int const n)
+{
+    return (n & 1 ? t0 : ~t0) & (n & 2 ? t1 : ~t1) & (n & 4 ? t2 : ~t2) & (n & 8 ? t3 : ~t3);
+}
+
+// next generation of 64 cells, neighbour count summed with bitwise adders
+// birth and survival are constants in the specialised kernels, the compiler keeps only the counts they use
+RULE_INLINE uint64_t LifeWord(
+        uint16_t const birth, uint16_t const survival,
+        uint64_t const nw, uint64_t const n, uint64_t const ne,
+        uint64_t const w, uint64_t const c, uint64_t const e,
+        uint64_t const sw, uint64_t const s, uint64_t const se)
+{
+    // 2-bit sums of the row above and below, 2-bit sum of the side cells
+    uint64_t const a0 = nw ^ n ^ ne, a1 = (nw & n) | (ne & (nw ^ n));
+    uint64_t const b0 = sw ^ s ^ se, b1 = (sw & s) | (se & (sw ^ s));
+    uint64_t const m0 = w ^ e, m1 = w & e;
+
+    uint64_t const s0 = a0 ^ b0, k0 = a0 & b0;
+    uint64_t const s1 = a1 ^ b1 ^ k0, s2 = (a1 & b1) | (k0 & (a1 ^ b1));
+
+    uint64_t const t0 = s0 ^ m0, k1 = s0 & m0;
+    uint64_t const t1 = s1 ^ m1 ^ k1, k2 = (s1 & m1) | (k1 & (s1 ^ m1));
+    uint64_t const t2 = s2 ^ k2, t3 = s2 & k2;
+
+    // B3/S23 : count is 2 or 3, and 2 only keeps a living cell
+    if (birth == CONWAY_BIRTH && survival == CONWAY_SURVIVAL)
+        return t1 & ~t2 & ~t3 & (t0 | c);
+
+    uint64_t born = 0, kept = 0;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 9
+#endif
+    for (int count = 0; count <= 8; ++count) {
+        uint64_t const is = CountIs(t0, t1, t2, t3, count);
+        born |= is & -(uint64_t)(birth >> count & 1);
+        kept |= is & -(uint64_t)(survival >> count & 1);
+    }
+    return (born & ~c) | (kept & c);
+}
+
+#endif //GOL_LIFEWORD_H
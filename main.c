@@ -3,76 +3,101 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <assert.h>
 #include <string.h>
 #include <float.h>
+#include <math.h>
 #include <stdbool.h>
-#include <time.h>
+#include <pthread.h>
 
 #include "util_glfw.h"
 #include "smoothlife.h"
 #include "lenia.h"
 #include "rafler.h"
+#include "bitlife.h"
+#include "workers.h"
+#include "conway.h"
+#include "wolfram.h"
+#include "simulation.h"
+#include "timing.h"
 
 //static int WIDTH = 1680;
 //static int HEIGHT = 1050;
 static int WIDTH = 640;
 static int HEIGHT = 480;
+static int BOARD_HEIGHT = 0; // cells, 0 : the window; another size of a bit engine gets the zoom and pan viewer
+static int BOARD_WIDTH = 0;
+static int THREADS = 0; // 0 : every hardware thread
+static double GENERATIONS_PER_SECOND = 0; // of the simulation thread, 0 : as fast as it goes whatever the refresh rate
+static double WOLFRAM_GENERATIONS_PER_SECOND = 0; // of LaunchWolfram, 0 : as fast as it goes, 60 scrolls a row per frame
+static char const *WOLFRAM_RULE = NULL; // "R2/T52" or "R3/B1/S012" for LaunchWolfram instead of the elementary rule of its seed
+static uint64_t HASHLIFE_STEP = 1; // generations per frame
+static size_t HASHLIFE_MEMORY = (size_t)1 << 30;
+static int CYCLE_HISTORY = 4096; // longest period looked for, CONWAY_BITS only
+static uint64_t CYCLE_TARGET = 0; // once a cycle is found, jump to this generation and stop, 0 : stop where it is
+static char const *LIFE_RULE = "B3/S23"; // B/S notation, "B36/S23" for HighLife
+static char const *PATTERN_FILE = NULL; // RLE, macrocell or plaintext centred on the board instead of a soup, its rule wins
+static char const *CHECKPOINT_FILE = NULL; // resumed from when it matches the board, rewritten every CHECKPOINT_EVERY generations
+static uint64_t CHECKPOINT_EVERY = 1000; // 0 : resume only
+
+// two bytes per cell for a STATE_ALIVE_HEAT view
+void ConvertDataToTexels(int height, int width, float const (*pixelData)[height][width][2],
+                         unsigned char (*texels)[height][width][2])
+{
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            (*texels)[y][x][0] = (*pixelData)[y][x][0] > FLT_EPSILON ? 255 : 0;
+            (*texels)[y][x][1] = (unsigned char)((*pixelData)[y][x][1] * 255 + .5f);
+        }
+    }
+}
+
+// owned by the simulation thread until StopSimulation
+struct WolfRun {
+    struct WolfKernel kernel;
+    int words;
+    uint64_t *history; // the last HEIGHT generations packed, generation g in row g % HEIGHT
+    uint64_t generation; // the newest one
+    uint64_t shown; // generations handed to the render thread so far
+};
 
-struct cellState {
-    float value;
-    float heat;
+// the rows new since the last frame, oldest first, generation g going to row g % HEIGHT of the ring;
+// the simulation thread only publishes once the last frame was taken, so none is ever skipped
+struct WolfFrame {
+    uint64_t newest;
+    int count;
+    unsigned char rows[];
 };
 
-void ConvertDataToColors(int height, int width, float const (*pixelData)[height][width][2], float (*pixelColors)[HEIGHT*WIDTH*3])
+static struct WolfRow WolfHistoryRow(struct WolfRun *run, uint64_t const generation)
 {
-    int k = 0;
-    for (int i = 0; i < HEIGHT*WIDTH; ++i) {
-        int const y = i / WIDTH;
-        int const x = i % WIDTH;
-        bool const is_on = (*pixelData)[y][x][0] > FLT_EPSILON;
-        float const heat = (*pixelData)[y][x][1];
-        float const r = is_on ? 1 : 0x18/255.f;
-        float const g = is_on ? 0.5f + (1-heat) * 0.5f : 0x18/255.f;
-        float const b = is_on ? 0.5f + (1-heat) * 0.5f : 0x18/255.f;
-
-        (*pixelColors)[k++] =r;
-        (*pixelColors)[k++] =g;
-        (*pixelColors)[k++] =b;
-    }
+    return (struct WolfRow){WIDTH, run->words, run->history + (size_t)(generation % HEIGHT) * run->words};
 }
 
-void IterateWolf(int const height, int const width, float (*pixelColors)[height][width][2], unsigned char const pattern, int const line)
+static bool StepWolfRun(void *context)
 {
-    for (int x = 0; x < width; x++) {
-        int const previous = ((int)(*pixelColors)[(height + line-1) % height][(width + x-1) % width][0] << 2)
-                       + ((int)(*pixelColors)[(height + line-1) % height][x][0] << 1)
-                       + ((int)(*pixelColors)[(height + line-1) % height][(x+1) % width][0] << 0);
-        assert(previous >= 0 && previous <= 7);
-
-        (*pixelColors)[line][x][0] = (_Bool )(pattern & (1 << previous));
-    }
+    struct WolfRun *run = context;
+    struct WolfRow const row = WolfHistoryRow(run, run->generation);
+    struct WolfRow next = WolfHistoryRow(run, run->generation + 1);
+    StepWolfKernel(&run->kernel, &row, &next);
+    run->generation++;
+    return true;
 }
 
-void InitWolf(int height, int width, float (*pixelColors)[height][width][2], unsigned char pattern) {
-    srand(42);
-    for (int i = 0; i < width; i++) {
-        //(*pixelColors)[0][i] = rand() & 1;
-        (*pixelColors)[0][i][0] = 0;
-        (*pixelColors)[0][i][1] = 0;
-    }
-    (*pixelColors)[0][width/2][0] = 1;
-    (*pixelColors)[0][width/2][1] = 1;
-
-    for (int y = 1; y < height; ++y) {
-        IterateWolf(height, width, pixelColors, pattern, y);
+static void PublishWolfRun(void *context, void *frame)
+{
+    struct WolfRun *run = context;
+    struct WolfFrame *rows = frame;
+    uint64_t const count = run->generation + 1 - run->shown;
+    rows->newest = run->generation;
+    rows->count = count < (uint64_t)HEIGHT ? (int)count : HEIGHT;
+    for (int i = 0; i < rows->count; ++i) {
+        struct WolfRow const row = WolfHistoryRow(run, run->generation + 1 - rows->count + i);
+        UnpackWolfRow(&row, rows->rows + (size_t)i * WIDTH);
     }
+    run->shown = run->generation + 1;
 }
 
 void LaunchWolfram(unsigned char seed) {
-    GLuint program;
-    GLint vpos_location, vcol_location;
-
     char title[200] = { 0 };
     sprintf(title, "Seed %u (%c%c%c%c%c%c%c%C)", seed
     , "01"[(_Bool)(seed & (1 << 7))]
@@ -84,158 +109,313 @@ void LaunchWolfram(unsigned char seed) {
     , "01"[(_Bool)(seed & (1 << 1))]
     , "01"[(_Bool)(seed & (1 << 0))]
     );
-    GLFWwindow* window = OpenWindow(title, WIDTH, HEIGHT, false, true);
-
-    //glEnable(GL_FRAMEBUFFER_SRGB);
 
-    // NOTE: OpenGL error checks have been omitted for brevity
+    struct WolfRule rule = WOLF_ELEMENTARY_RULE(seed);
+    if (WOLFRAM_RULE != NULL) {
+        if (!ParseWolfRule(WOLFRAM_RULE, &rule)) {
+            fprintf(stderr, "not a wolfram rule: %s\n", WOLFRAM_RULE);
+            exit(EXIT_FAILURE);
+        }
+        FormatWolfRule(rule, title);
+    }
+    struct WolfRun run = {.kernel = SelectWolfKernel(rule), .words = (WIDTH + 63) / 64};
+    run.history = calloc((size_t)HEIGHT * run.words, sizeof *run.history);
+    if (run.history == NULL) {
+        fprintf(stderr, "fail to generate the rows on CPU\n");
+        exit(EXIT_FAILURE);
+    }
 
-    GLfloat maxPointSize[2];
-    glGetFloatv(GL_POINT_SIZE_RANGE, maxPointSize);
-    printf("Maximum point size: %f, %f\n", maxPointSize[0], maxPointSize[1]);
+    // the first screen at once, like InitWolf did
+    struct WolfRow first = WolfHistoryRow(&run, 0);
+    InitWolfRow(&first);
+    for (int y = 1; y < HEIGHT; ++y)
+        StepWolfRun(&run);
 
-    LoadShaders(&program, &vpos_location, &vcol_location);
+    GLFWwindow* window = OpenWindow(title, WIDTH, HEIGHT, false, true);
 
+    // the last HEIGHT generations in a texture used as a ring, the shader scrolls it
+    GLuint const program = LoadProgram("shaders/vertex_to_tex.vert", "shaders/wolfram_ring.frag");
+    GLint const newest_location = glGetUniformLocation(program, "newest");
     GLuint VAO, VBO;
-
-    float (*pixelData)[HEIGHT][WIDTH][2] = malloc(sizeof (float[HEIGHT][WIDTH][2]));
-    float (*pixelColors)[HEIGHT*WIDTH*3] = malloc(sizeof (float[HEIGHT*WIDTH*3]));
-    if(pixelData == NULL || pixelColors == NULL) {
-        fprintf(stderr, "fail to generate color buffer on CPU\n");
+    CreateScreenQuad(&VAO, &VBO);
+
+    GLuint ring;
+    glGenTextures(1, &ring);
+    glBindTexture(GL_TEXTURE_2D, ring);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, WIDTH, HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // the rows step on their own thread, the first frame carries the whole screen
+    struct SimulationThread simulation;
+    if (!StartSimulation(&simulation, sizeof(struct WolfFrame) + (size_t)HEIGHT * WIDTH,
+                         WOLFRAM_GENERATIONS_PER_SECOND, StepWolfRun, PublishWolfRun, &run)) {
+        fprintf(stderr, "fail to start the simulation thread\n");
         exit(EXIT_FAILURE);
     }
 
-    InitWolf(HEIGHT, WIDTH, pixelData, seed);
-
-    int offset = GeneratePixelData(HEIGHT, WIDTH, pixelColors, vpos_location, vcol_location, &VAO, &VBO);
-
     glClearColor(0x18/255.f, 0x18/255.f,0x18/255.f, 1);
 
-    int line = 0;
+    double start = WallSeconds();
+    uint64_t start_generations = 0;
+    int iterations = 0;
+    int newest = 0;
     while (!glfwWindowShouldClose(window))
     {
-        //float ratio;
         int width, height;
-        // mat4x4 m, p, mvp;
-
         glfwGetFramebufferSize(window, &width, &height);
-        //ratio = (float) width / (float) height;
-
-        // resize if window is resized
         glViewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        /*
-        mat4x4_identity(m);
-        mat4x4_rotate_Z(m, m, (float) glfwGetTime());
-        mat4x4_ortho(p, -ratio, ratio, -1.f, 1.f, 1.f, -1.f);
-        mat4x4_mul(mvp, p, m);
-         */
-
-        //glUseProgram(program);
-        //glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*) mvp);
-        //glDrawArrays(GL_TRIANGLES, 0, vertix_count);
-
-        IterateWolf(HEIGHT, WIDTH, pixelData, seed, line++);
-        line %= HEIGHT;
-
-        int k = 0;
-        for (int i = 0; i < HEIGHT*WIDTH; ++i) {
-            bool is_on = (*pixelData)[i / WIDTH][i % WIDTH];
-            float r = is_on ? 1.f : 0x18/255.f;
-            float g = is_on ? 1.f : 0x18/255.f;
-            float b = is_on ? 1.f : 0x18/255.f;
-
-            (*pixelColors)[k++] =r;
-            (*pixelColors)[k++] =g;
-            (*pixelColors)[k++] =b;
+        // one row of WIDTH bytes goes up per generation, in at most two runs where the ring wraps;
+        // the rest of the ring stays on the GPU
+        bool fresh;
+        struct WolfFrame const *frame = LatestSimulationFrame(&simulation, &fresh);
+        if (fresh) {
+            uint64_t const oldest = frame->newest + 1 - frame->count;
+            for (int i = 0; i < frame->count;) {
+                int const y = (int)((oldest + i) % HEIGHT);
+                int const rows = frame->count - i < HEIGHT - y ? frame->count - i : HEIGHT - y;
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, WIDTH, rows, GL_RED, GL_UNSIGNED_BYTE,
+                                frame->rows + (size_t)i * WIDTH);
+                i += rows;
+            }
+            newest = (int)(frame->newest % HEIGHT);
         }
-        RenderPixels(WIDTH*HEIGHT, program, VAO, HEIGHT, WIDTH, offset, pixelColors);
+
+        glUseProgram(program);
+        glUniform1i(newest_location, newest);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        double const now = WallSeconds();
+        if (now - start >= 1)
+        {
+            uint64_t const generations = SimulationGenerations(&simulation);
+            printf("FPS: %d, %.0f generations/s\n", iterations,
+                   (double)(generations - start_generations) / (now - start));
+            iterations = 0;
+            start = now;
+            start_generations = generations;
+        }
+        iterations++;
     }
 
-    free(pixelData);
-    free(pixelColors);
+    StopSimulation(&simulation);
+    free(run.history);
+    glDeleteTextures(1, &ring);
+    glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteProgram(program);
 
     glfwDestroyWindow(window);
 
     glfwTerminate();
 }
 
-void InitConway(int const height, int const width, float (*pixelData)[height][width][2], signed char const pattern) {
-    srand(pattern);
+// the scroll wheel zooms around the cursor, dragging with the left button pans
+struct ConwayViewer {
+    pthread_mutex_t lock; // of viewport, read by the simulation thread when it renders a frame
+    struct Viewport viewport;
+    double min_scale;
+    double max_scale;
+    struct SimulationThread *simulation;
+
+    // the render thread only
+    bool dragging;
+    double cursor_x; // pixels of the view
+    double cursor_y;
+};
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; x++) {
-            (*pixelData)[y][x][0] = (float)(rand() & 1);
-            (*pixelData)[y][x][1] = 1;
-        }
+// owned by the simulation thread until StopSimulation
+struct ConwayRun {
+    struct Conway conway;
+    size_t bits_size; // bytes of the words of the bit engines, 0 for the float ones
+    struct ConwayViewer *viewer; // nullptr : one cell per pixel of the view
+    double last_print;
+};
+
+static bool StepConwayRun(void *context)
+{
+    struct ConwayRun *run = context;
+    struct Conway *conway = &run->conway;
+    if (conway->settled)
+        return false;
+    StepConway(conway);
+
+    double const now = WallSeconds();
+    if (now - run->last_print >= 1) {
+        if (conway->engine == CONWAY_BITS)
+            printf("active tiles: %d / %d\n", conway->tiles.active_count, conway->tiles.rows * conway->tiles.columns);
+        if (conway->engine == CONWAY_HASHLIFE)
+            printf("generation %llu, population %llu, %zu nodes\n",
+                   (unsigned long long)conway->generation,
+                   (unsigned long long)ConwayPopulation(conway), HashLifeNodeCount(conway->life));
+        if (conway->engine == CONWAY_CHUNKS)
+            printf("generation %llu, population %llu, %zu chunks\n",
+                   (unsigned long long)conway->generation,
+                   (unsigned long long)ConwayPopulation(conway), ChunkWorldChunkCount(conway->world));
+        run->last_print = now;
     }
+    return true;
 }
 
-void IterateConway(
-        int const height, int const width, float (*pixelColors)[height][width][2],
-        float (*newPixelColors)[height][width][2], struct cellState(*rule)(float, float, float)) {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; x++) {
-            float const moore = (*pixelColors)[(y + height -1)%height][(x+width-1)%width][0]
-            + (*pixelColors)[(y + height -1)%height][x][0]
-            + (*pixelColors)[(y + height -1)%height][(x+1)%width][0]
+// the bit engines hand their words as they are, the float ones two bytes per cell;
+// through the viewer, the densities of what is on screen
+static void PublishConwayRun(void *context, void *frame)
+{
+    struct ConwayRun *run = context;
+    if (run->viewer != NULL) {
+        pthread_mutex_lock(&run->viewer->lock);
+        struct Viewport const viewport = run->viewer->viewport;
+        pthread_mutex_unlock(&run->viewer->lock);
+        struct DensityPyramid const *pyramid = ConwayPyramid(&run->conway);
+        RenderDensityView(pyramid, &run->conway.grid, viewport, HEIGHT, WIDTH, frame);
+    } else if (run->bits_size != 0)
+        memcpy(frame, ConwayBits(&run->conway)->cells, run->bits_size);
+    else
+        ConvertDataToTexels(HEIGHT, WIDTH, run->conway.pixelData, frame);
+}
 
-            + (*pixelColors)[y][(x+width-1)%width][0]
-            + (*pixelColors)[y][(x+1)%width][0]
+// the cursor in pixels of the view, which is stretched over the whole window
+static void ViewCursor(GLFWwindow* window, double *x, double *y)
+{
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    glfwGetCursorPos(window, x, y);
+    *x = *x * WIDTH / (width > 0 ? width : 1);
+    *y = *y * HEIGHT / (height > 0 ? height : 1);
+}
 
-            + (*pixelColors)[(y+1)%height][(x+width-1)%width][0]
-            + (*pixelColors)[(y+1)%height][x][0]
-            + (*pixelColors)[(y+1)%height][(x+1)%width][0];
+static void ZoomConwayViewer(GLFWwindow* window, double xoffset, double yoffset)
+{
+    (void)xoffset;
+    struct ConwayViewer *viewer = glfwGetWindowUserPointer(window);
+    double x, y;
+    ViewCursor(window, &x, &y);
+
+    pthread_mutex_lock(&viewer->lock);
+    struct Viewport *viewport = &viewer->viewport;
+    double scale = viewport->scale * pow(.8, yoffset);
+    scale = fmax(viewer->min_scale, fmin(viewer->max_scale, scale));
+    // the cell under the cursor stays under it
+    viewport->x += x * (viewport->scale - scale);
+    viewport->y += y * (viewport->scale - scale);
+    viewport->scale = scale;
+    pthread_mutex_unlock(&viewer->lock);
+    RepublishSimulation(viewer->simulation);
+}
 
-            struct cellState const s = rule((*pixelColors)[y][x][0], (*pixelColors)[y][x][1], moore);
-            (*newPixelColors)[y][x][0] = s.value;
-            (*newPixelColors)[y][x][1] = s.heat;
-        }
+static void GrabConwayViewer(GLFWwindow* window, int button, int action, int mods)
+{
+    (void)mods;
+    struct ConwayViewer *viewer = glfwGetWindowUserPointer(window);
+    if (button == GLFW_MOUSE_BUTTON_LEFT) {
+        viewer->dragging = action == GLFW_PRESS;
+        ViewCursor(window, &viewer->cursor_x, &viewer->cursor_y);
     }
-
-   // memcpy(pixelColors, newPixelColors, sizeof *newPixelColors);
 }
 
-static struct cellState conway_rule(float const current_state, float const heat, float const moore_number) {
-    if (current_state && (moore_number == 2 || moore_number == 3))
-        return (struct cellState){1, heat * .99f};
-    if (!current_state && (moore_number == 3))
-        return (struct cellState){1, 1};
-    return (struct cellState){0, 0};
+static void PanConwayViewer(GLFWwindow* window, double xpos, double ypos)
+{
+    (void)xpos, (void)ypos;
+    struct ConwayViewer *viewer = glfwGetWindowUserPointer(window);
+    if (!viewer->dragging)
+        return;
+    double x, y;
+    ViewCursor(window, &x, &y);
+
+    pthread_mutex_lock(&viewer->lock);
+    viewer->viewport.x -= (x - viewer->cursor_x) * viewer->viewport.scale;
+    viewer->viewport.y -= (y - viewer->cursor_y) * viewer->viewport.scale;
+    pthread_mutex_unlock(&viewer->lock);
+    viewer->cursor_x = x;
+    viewer->cursor_y = y;
+    RepublishSimulation(viewer->simulation);
 }
 
-void LaunchConway(signed char seed)
+void LaunchConway(uint64_t seed, enum ConwayEngine engine)
 {
-    // passé en ur a openGL, du coup tableau flat
-    float (*pixelColors)[HEIGHT*WIDTH*3] = malloc(sizeof *pixelColors);
-    float (*pixelData)[HEIGHT][WIDTH][2] = malloc(sizeof *pixelData);
-    float (*newPixelData)[HEIGHT][WIDTH][2] = malloc(sizeof *newPixelData);
-
-    if(pixelColors == NULL || newPixelData == NULL || pixelData == NULL) {
-        fprintf(stderr, "fail to generate color buffer on CPU\n");
+    int const board_height = BOARD_HEIGHT > 0 ? BOARD_HEIGHT : HEIGHT;
+    int const board_width = BOARD_WIDTH > 0 ? BOARD_WIDTH : WIDTH;
+    bool const zoomed = board_height != HEIGHT || board_width != WIDTH;
+    if (zoomed && (engine == CONWAY_FLOAT || engine == CONWAY_FLOAT_SIMD)) {
+        fprintf(stderr, "a board of %dx%d needs a bit engine for the viewer\n", board_width, board_height);
         exit(EXIT_FAILURE);
     }
 
-    InitConway(HEIGHT, WIDTH, pixelData, seed);
-
-    GLFWwindow* window = OpenWindow("GOL", WIDTH, HEIGHT, true, true);
+    struct ConwaySettings settings = {
+        .height = board_height,
+        .width = board_width,
+        .pattern_file = PATTERN_FILE,
+        .hashlife_step = HASHLIFE_STEP,
+        .hashlife_memory = HASHLIFE_MEMORY,
+        .cycle_history = CYCLE_HISTORY,
+        .cycle_target = CYCLE_TARGET,
+        .checkpoint_file = CHECKPOINT_FILE,
+        .checkpoint_every = CHECKPOINT_EVERY,
+        .pyramid = zoomed,
+    };
+    if (!ParseLifeRule(LIFE_RULE, &settings.rule)) {
+        fprintf(stderr, "not a B/S rule: %s\n", LIFE_RULE);
+        exit(EXIT_FAILURE);
+    }
 
-    GLuint program, VAO, VBO;
-    GLint vpos_location, vcol_location;
+    struct WorkerPool *pool = CreateWorkerPool(THREADS);
+    if (pool == NULL) {
+        fprintf(stderr, "fail to start the worker pool\n");
+        exit(EXIT_FAILURE);
+    }
 
-    LoadShaders(&program, &vpos_location, &vcol_location);
+    struct ConwayRun run = {.last_print = WallSeconds()};
+    CreateConway(&run.conway, engine, &settings, seed, pool);
+    printf("Conway workers: %d\n", WorkerCount(pool));
+
+    char title[32] = "GOL ";
+    strcat(title, run.conway.rule_text);
+    GLFWwindow* window = OpenWindow(title, WIDTH, HEIGHT, true, true);
+
+    bool const bit_engine = ConwayBits(&run.conway) != NULL;
+    struct StateView view;
+    CreateStateView(&view, zoomed ? STATE_INTENSITY : bit_engine ? STATE_BITS : STATE_ALIVE_HEAT, HEIGHT, WIDTH,
+                    (struct StatePalette){{0x18/255.f, 0x18/255.f, 0x18/255.f},
+                                          {1, bit_engine ? .5f : 1, bit_engine ? .5f : 1}});
+    run.bits_size = bit_engine && !zoomed ? view.size : 0;
+
+    // the whole board to start with, centred
+    struct SimulationThread simulation;
+    struct ConwayViewer viewer = {.simulation = &simulation};
+    if (zoomed) {
+        double const scale = fmax((double)board_width / WIDTH, (double)board_height / HEIGHT);
+        viewer.viewport = (struct Viewport){(board_width - WIDTH * scale) / 2, (board_height - HEIGHT * scale) / 2,
+                                            scale};
+        viewer.min_scale = 1. / 32;
+        viewer.max_scale = 2 * scale;
+        pthread_mutex_init(&viewer.lock, NULL);
+        run.viewer = &viewer;
+        printf("%dx%d board, a density pyramid of %d levels\n", board_width, board_height, run.conway.pyramid.levels);
+    }
 
-    long offset = GeneratePixelData(HEIGHT, WIDTH, pixelColors, vpos_location, vcol_location, &VAO, &VBO);
+    // the engine steps on its own thread, the window shows the newest generation at every refresh
+    if (!StartSimulation(&simulation, view.size, GENERATIONS_PER_SECOND, StepConwayRun, PublishConwayRun, &run)) {
+        fprintf(stderr, "fail to start the simulation thread\n");
+        exit(EXIT_FAILURE);
+    }
+    if (zoomed) {
+        glfwSetWindowUserPointer(window, &viewer);
+        glfwSetScrollCallback(window, ZoomConwayViewer);
+        glfwSetMouseButtonCallback(window, GrabConwayViewer);
+        glfwSetCursorPosCallback(window, PanConwayViewer);
+    }
 
     glClearColor(0x18/255.f, 0x18/255.f,0x18/255.f, 1);
 
-    clock_t start_clock = clock();
-    printf("clock start %lu\n", start_clock);
-
+    double start = WallSeconds();
+    uint64_t start_generations = 0;
     int iterations = 0;
 
     while (!glfwWindowShouldClose(window))
@@ -248,31 +428,35 @@ void LaunchConway(signed char seed)
 
         glClear(GL_COLOR_BUFFER_BIT);
 
-        IterateConway(HEIGHT, WIDTH, pixelData, newPixelData, conway_rule);
-        ConvertDataToColors(HEIGHT, WIDTH, pixelData, pixelColors);
-        RenderPixels(WIDTH*HEIGHT, program, VAO, HEIGHT, WIDTH, offset, pixelColors);
+        bool fresh;
+        void const *frame = LatestSimulationFrame(&simulation, &fresh);
+        if (fresh)
+            UploadStateView(&view, frame);
+        DrawStateView(&view);
+        PrintStateUploads(&view);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
 
-        // intervertit les buffers
-        void*tmp = pixelData;
-        pixelData = newPixelData;
-        newPixelData = tmp;
-
-        clock_t const current_clock = clock();
-        if ((double)(current_clock - start_clock) / CLOCKS_PER_SEC >= 1)
+        double const now = WallSeconds();
+        if (now - start >= 1)
         {
-            printf("FPS: %d\n", iterations);
+            uint64_t const generations = SimulationGenerations(&simulation);
+            printf("FPS: %d, %.0f generations/s\n", iterations,
+                   (double)(generations - start_generations) / (now - start));
             iterations = 0;
-            start_clock = current_clock;
+            start = now;
+            start_generations = generations;
         }
         iterations++;
     }
 
-    free(pixelColors);
-    free(pixelData);
-    free(newPixelData);
+    StopSimulation(&simulation);
+    if (zoomed)
+        pthread_mutex_destroy(&viewer.lock);
+    FreeConway(&run.conway);
+    FreeStateView(&view);
+    FreeWorkerPool(pool);
 
     glfwDestroyWindow(window);
 
@@ -287,7 +471,8 @@ int main(void)
     //for(unsigned char i = 160; i< 255; i++)
     //    LaunchWolfram(i);
     //LaunchWolfram(30);
-    LaunchConway(90);
+    LaunchConway(90, CONWAY_FLOAT);
+    //LaunchConway(90, CONWAY_BITS); // no heat, boards far bigger than the screen
     //LaunchWolfram(135);
     //LaunchWolfram(169); // croissant
 
@@ -0,0 +1,85 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapfile.h"
+
+bool MapFile(char const *path, bool const sequential, struct MappedFile *file)
+{
+    *file = (struct MappedFile){.data = ""};
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) {
+        CloseHandle(handle);
+        return false;
+    }
+    file->size = (size_t)size.QuadPart;
+
+    if (file->size > 0) {
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(handle);
+        if (mapping == nullptr)
+            return false;
+        file->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (file->data == nullptr) {
+            CloseHandle(mapping);
+            return false;
+        }
+        file->handle = mapping;
+    } else {
+        CloseHandle(handle);
+    }
+#else
+    int const descriptor = open(path, O_RDONLY);
+    if (descriptor < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        return false;
+    }
+    file->size = (size_t)status.st_size;
+
+    if (file->size > 0) {
+        void *data = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        close(descriptor);
+        if (data == MAP_FAILED)
+            return false;
+        // the kernel can read ahead and drop what is behind
+        if (sequential)
+            madvise(data, file->size, MADV_SEQUENTIAL);
+        file->data = data;
+        file->handle = data;
+    } else {
+        close(descriptor);
+    }
+#endif
+
+    return true;
+}
+
+void UnmapFile(struct MappedFile *file)
+{
+#ifdef _WIN32
+    if (file->handle != nullptr) {
+        UnmapViewOfFile(file->data);
+        CloseHandle(file->handle);
+    }
+#else
+    if (file->handle != nullptr)
+        munmap(file->handle, file->size);
+#endif
+    *file = (struct MappedFile){.data = ""};
+}
@@ -0,0 +1,21 @@
+//
+// Read-only memory mapping of a whole file, POSIX or Windows.
+//
+
+#ifndef GOL_MAPFILE_H
+#define GOL_MAPFILE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct MappedFile {
+    char const *data; // "" for an empty file
+    size_t size;
+    void *handle; // what UnmapFile gives back to the system
+};
+
+// sequential tells the system the file is read once front to back
+bool MapFile(char const *path, bool sequential, struct MappedFile *file);
+void UnmapFile(struct MappedFile *file);
+
+#endif //GOL_MAPFILE_H
@@ -0,0 +1,641 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include "pattern.h"
+
+// where the decoder is in the mapping, nothing is ever copied out of it
+struct Cursor {
+    char const *at;
+    char const *end;
+};
+
+static inline bool IsDigit(char const c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool IsBlank(char const c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void SkipLine(struct Cursor *cursor)
+{
+    char const *newline = memchr(cursor->at, '\n', cursor->end - cursor->at);
+    cursor->at = newline != nullptr ? newline + 1 : cursor->end;
+}
+
+static void SkipBlanks(struct Cursor *cursor)
+{
+    while (cursor->at < cursor->end && IsBlank(*cursor->at))
+        cursor->at++;
+}
+
+static bool ReadNumber(struct Cursor *cursor, int64_t *number)
+{
+    SkipBlanks(cursor);
+    if (cursor->at == cursor->end || !IsDigit(*cursor->at))
+        return false;
+
+    int64_t value = 0;
+    while (cursor->at < cursor->end && IsDigit(*cursor->at)) {
+        if (value > (INT64_MAX - 9) / 10)
+            return false;
+        value = value * 10 + (*cursor->at++ - '0');
+    }
+    *number = value;
+    return true;
+}
+
+// the rule text runs until a comma, a ':' (bounded grids) or the end of the line
+static bool ReadRule(struct Cursor *cursor, struct LifeRule *rule)
+{
+    char text[64];
+    size_t length = 0;
+
+    SkipBlanks(cursor);
+    while (cursor->at < cursor->end && *cursor->at != ',' && *cursor->at != '\n' && *cursor->at != ':') {
+        if (length < sizeof text - 1)
+            text[length++] = *cursor->at;
+        cursor->at++;
+    }
+    text[length] = '\0';
+
+    return ParseLifeRule(text, rule);
+}
+
+bool OpenPatternFile(char const *path, struct PatternFile *file)
+{
+    *file = (struct PatternFile){0};
+    if (!MapFile(path, true, &file->mapping))
+        return false;
+    file->data = file->mapping.data;
+    file->size = file->mapping.size;
+
+    // the first line that is not a comment tells the format
+    struct Cursor cursor = {file->data, file->data + file->size};
+    if (file->size >= 2 && file->data[0] == '[' && file->data[1] == 'M') {
+        file->format = PATTERN_MACROCELL;
+    } else {
+        while (cursor.at < cursor.end) {
+            SkipBlanks(&cursor);
+            if (cursor.at == cursor.end || *cursor.at == '#' || *cursor.at == '\n') {
+                SkipLine(&cursor);
+                continue;
+            }
+            char const c = *cursor.at;
+            if (c == 'x')
+                file->format = PATTERN_RLE;
+            else if (c == '!' || c == '.' || c == 'O' || c == '*')
+                file->format = PATTERN_PLAINTEXT;
+            break;
+        }
+    }
+
+    if (file->format == PATTERN_UNKNOWN) {
+        ClosePatternFile(file);
+        return false;
+    }
+
+    return true;
+}
+
+void ClosePatternFile(struct PatternFile *file)
+{
+    UnmapFile(&file->mapping);
+    *file = (struct PatternFile){0};
+}
+
+static inline void Emit(struct PatternSink const *sink, int64_t x, int64_t const y, int64_t length)
+{
+    if (y < sink->y0 || y >= sink->y1)
+        return;
+    if (x < sink->x0) {
+        length -= sink->x0 - x;
+        x = sink->x0;
+    }
+    if (x + length > sink->x1)
+        length = sink->x1 - x;
+    if (length > 0)
+        sink->run(sink->context, x, y, length);
+}
+
+// RLE
+
+// leaves the cursor on the first line of cells
+static bool ReadRleHeader(struct Cursor *cursor, struct PatternInfo *info)
+{
+    *info = (struct PatternInfo){0};
+
+    while (cursor->at < cursor->end) {
+        SkipBlanks(cursor);
+        if (cursor->at < cursor->end && (*cursor->at == '#' || *cursor->at == '\n')) {
+            SkipLine(cursor);
+            continue;
+        }
+        break;
+    }
+
+    bool has_x = false, has_y = false;
+    while (cursor->at < cursor->end && *cursor->at != '\n') {
+        SkipBlanks(cursor);
+        if (cursor->at == cursor->end || *cursor->at == '\n')
+            break;
+        char const key = *cursor->at;
+        while (cursor->at < cursor->end && *cursor->at != '=' && *cursor->at != '\n')
+            cursor->at++;
+        if (cursor->at == cursor->end || *cursor->at != '=')
+            return false;
+        cursor->at++;
+
+        if (key == 'x')
+            has_x = ReadNumber(cursor, &info->width);
+        else if (key == 'y')
+            has_y = ReadNumber(cursor, &info->height);
+        else if (key == 'r') {
+            // last key, a bounded grid suffix like :T100,100 has commas of its own
+            info->has_rule = ReadRule(cursor, &info->rule);
+            break;
+        }
+
+        // anything else runs to the next key
+        while (cursor->at < cursor->end && *cursor->at != ',' && *cursor->at != '\n')
+            cursor->at++;
+        if (cursor->at < cursor->end && *cursor->at == ',')
+            cursor->at++;
+    }
+    SkipLine(cursor);
+
+    return has_x && has_y;
+}
+
+static bool DecodeRle(struct Cursor cursor, struct PatternSink const *sink)
+{
+    struct PatternInfo info;
+    if (!ReadRleHeader(&cursor, &info))
+        return false;
+
+    int64_t x = 0, y = 0, count = 0;
+    for (; cursor.at < cursor.end; cursor.at++) {
+        char const c = *cursor.at;
+        if (IsDigit(c)) {
+            if (count > (INT64_MAX - 9) / 10)
+                return false;
+            count = count * 10 + (c - '0');
+            continue;
+        }
+
+        // a run past the end of the plane is a broken file, not a wrap around
+        int64_t const n = count ? count : 1;
+        if (c == 'b' || c == '.') {
+            if (n > INT64_MAX - x)
+                return false;
+            x += n;
+        } else if (c == '$') {
+            if (n > INT64_MAX - y)
+                return false;
+            x = 0;
+            y += n;
+        } else if (c == '!') {
+            break;
+        } else if (c >= 'p' && c <= 'y') {
+            continue; // prefix of a multi-state letter, the count carries over
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'X')) {
+            if (n > INT64_MAX - x)
+                return false;
+            Emit(sink, x, y, n);
+            x += n;
+        } else if (c == '#') {
+            struct Cursor line = {cursor.at, cursor.end};
+            SkipLine(&line);
+            cursor.at = line.at - 1;
+        } else {
+            continue; // blanks and line breaks between tokens
+        }
+        count = 0;
+    }
+
+    return true;
+}
+
+// plaintext
+
+static bool DecodePlaintext(struct Cursor cursor, struct PatternSink const *sink, struct PatternInfo *info)
+{
+    int64_t y = 0, width = 0;
+
+    while (cursor.at < cursor.end) {
+        if (*cursor.at == '!') {
+            SkipLine(&cursor);
+            continue;
+        }
+
+        int64_t x = 0, run = 0;
+        for (; cursor.at < cursor.end && *cursor.at != '\n'; cursor.at++) {
+            char const c = *cursor.at;
+            if (c == 'O' || c == '*') {
+                run++;
+            } else if (c == '.') {
+                if (run && sink != nullptr)
+                    Emit(sink, x - run, y, run);
+                run = 0;
+            } else if (c == '\r') {
+                continue;
+            } else {
+                return false;
+            }
+            x++;
+        }
+        if (run && sink != nullptr)
+            Emit(sink, x - run, y, run);
+        if (cursor.at < cursor.end)
+            cursor.at++;
+
+        width = x > width ? x : width;
+        y++;
+    }
+
+    if (info != nullptr)
+        *info = (struct PatternInfo){.width = width, .height = y};
+    return true;
+}
+
+// macrocell
+
+enum MacroLine {
+    MACRO_SKIP,
+    MACRO_RULE,
+    MACRO_LEAF,
+    MACRO_NODE,
+    MACRO_BAD,
+};
+
+struct MacroNode {
+    int level; // 3 for a leaf
+    uint64_t leaf; // bit 8 * y + x
+    int64_t children[4]; // nw ne sw se, 1 based node lines, 0 is empty
+};
+
+static enum MacroLine ReadMacroLine(struct Cursor *cursor, struct MacroNode *node, struct LifeRule *rule)
+{
+    char const c = *cursor->at;
+
+    if (c == '[' || c == '\n' || c == '\r') {
+        SkipLine(cursor);
+        return MACRO_SKIP;
+    }
+    if (c == '#') {
+        if (cursor->end - cursor->at < 2) {
+            cursor->at = cursor->end;
+            return MACRO_SKIP;
+        }
+        bool const is_rule = cursor->at[1] == 'R';
+        cursor->at += 2;
+        bool const ok = is_rule && ReadRule(cursor, rule);
+        SkipLine(cursor);
+        return ok ? MACRO_RULE : MACRO_SKIP;
+    }
+
+    if (c == '.' || c == '*' || c == '$') {
+        int x = 0, y = 0;
+        node->level = 3;
+        node->leaf = 0;
+        for (; cursor->at < cursor->end && *cursor->at != '\n'; cursor->at++) {
+            char const cell = *cursor->at;
+            if (cell == '$') {
+                x = 0;
+                y++;
+            } else if (cell == '.' || cell == '*') {
+                if (x >= 8 || y >= 8)
+                    return MACRO_BAD;
+                node->leaf |= (uint64_t)(cell == '*') << (8 * y + x);
+                x++;
+            } else if (!IsBlank(cell)) {
+                return MACRO_BAD;
+            }
+        }
+        SkipLine(cursor);
+        return MACRO_LEAF;
+    }
+
+    int64_t level;
+    if (!ReadNumber(cursor, &level) || level < 4 || level > 62)
+        return MACRO_BAD;
+    node->level = (int)level;
+    for (int q = 0; q < 4; ++q)
+        if (!ReadNumber(cursor, &node->children[q]) || node->children[q] < 0)
+            return MACRO_BAD;
+    SkipLine(cursor);
+    return MACRO_NODE;
+}
+
+// nodes, in file order, only their shape, the text is not kept
+struct MacroTree {
+    struct MacroNode *nodes; // nodes[0] is the empty node
+    int64_t count;
+    int64_t capacity;
+};
+
+static bool ReadMacroTree(struct Cursor cursor, struct MacroTree *tree, struct PatternInfo *info)
+{
+    *tree = (struct MacroTree){0};
+    *info = (struct PatternInfo){0};
+
+    while (cursor.at < cursor.end) {
+        struct MacroNode node;
+        enum MacroLine const line = ReadMacroLine(&cursor, &node, &info->rule);
+        if (line == MACRO_BAD) {
+            free(tree->nodes);
+            return false;
+        }
+        if (line == MACRO_RULE)
+            info->has_rule = true;
+        if (line != MACRO_LEAF && line != MACRO_NODE)
+            continue;
+
+        if (tree->count + 1 >= tree->capacity) {
+            tree->capacity = tree->capacity ? tree->capacity * 2 : 1024;
+            struct MacroNode *nodes = realloc(tree->nodes, tree->capacity * sizeof *nodes);
+            if (nodes == nullptr) {
+                free(tree->nodes);
+                return false;
+            }
+            tree->nodes = nodes;
+        }
+        if (line == MACRO_NODE)
+            for (int q = 0; q < 4; ++q)
+                if (node.children[q] > tree->count || (node.children[q] != 0
+                    && tree->nodes[node.children[q]].level != node.level - 1)) {
+                    free(tree->nodes);
+                    return false;
+                }
+        tree->nodes[++tree->count] = node;
+    }
+
+    if (tree->count == 0) {
+        free(tree->nodes);
+        return false;
+    }
+    info->width = info->height = (int64_t)1 << tree->nodes[tree->count].level;
+    return true;
+}
+
+static void ExpandMacroNode(struct MacroTree const *tree, int64_t const index, int64_t const x, int64_t const y,
+                            struct PatternSink const *sink)
+{
+    if (index == 0)
+        return;
+
+    struct MacroNode const *node = &tree->nodes[index];
+    int64_t const size = (int64_t)1 << node->level;
+    if (x >= sink->x1 || y >= sink->y1 || x + size <= sink->x0 || y + size <= sink->y0)
+        return;
+
+    if (node->level == 3) {
+        for (int row = 0; row < 8; ++row) {
+            unsigned const bits = node->leaf >> (8 * row) & 0xff;
+            for (int start = 0, end; start < 8; start = end + 1) {
+                while (start < 8 && !(bits >> start & 1))
+                    start++;
+                for (end = start; end < 8 && bits >> end & 1; end++);
+                if (end > start)
+                    Emit(sink, x + start, y + row, end - start);
+            }
+        }
+        return;
+    }
+
+    int64_t const half = size / 2;
+    ExpandMacroNode(tree, node->children[0], x, y, sink);
+    ExpandMacroNode(tree, node->children[1], x + half, y, sink);
+    ExpandMacroNode(tree, node->children[2], x, y + half, sink);
+    ExpandMacroNode(tree, node->children[3], x + half, y + half, sink);
+}
+
+// the last line of a macrocell file is its root, its level is the size
+static bool ReadMacrocellInfo(struct Cursor const cursor, struct PatternInfo *info)
+{
+    *info = (struct PatternInfo){0};
+
+    struct Cursor header = cursor;
+    while (header.at < header.end && (*header.at == '[' || *header.at == '#')) {
+        struct MacroNode unused;
+        if (ReadMacroLine(&header, &unused, &info->rule) == MACRO_RULE)
+            info->has_rule = true;
+    }
+
+    char const *end = cursor.end;
+    while (end > cursor.at && (end[-1] == '\n' || IsBlank(end[-1])))
+        end--;
+    char const *start = end;
+    while (start > cursor.at && start[-1] != '\n')
+        start--;
+
+    if (start == end)
+        return false;
+    struct Cursor last = {start, end};
+    struct MacroNode root;
+    enum MacroLine const line = ReadMacroLine(&last, &root, &info->rule);
+    if (line != MACRO_LEAF && line != MACRO_NODE)
+        return false;
+
+    info->width = info->height = (int64_t)1 << root.level;
+    return true;
+}
+
+bool ReadPatternInfo(struct PatternFile const *file, struct PatternInfo *info)
+{
+    struct Cursor cursor = {file->data, file->data + file->size};
+
+    switch (file->format) {
+    case PATTERN_RLE:
+        return ReadRleHeader(&cursor, info);
+    case PATTERN_PLAINTEXT:
+        return DecodePlaintext(cursor, nullptr, info);
+    case PATTERN_MACROCELL:
+        return ReadMacrocellInfo(cursor, info);
+    case PATTERN_UNKNOWN:
+        break;
+    }
+    return false;
+}
+
+bool DecodePattern(struct PatternFile const *file, struct PatternSink const *sink)
+{
+    struct Cursor const cursor = {file->data, file->data + file->size};
+
+    switch (file->format) {
+    case PATTERN_RLE:
+        return DecodeRle(cursor, sink);
+    case PATTERN_PLAINTEXT:
+        return DecodePlaintext(cursor, sink, nullptr);
+    case PATTERN_MACROCELL: {
+        struct MacroTree tree;
+        struct PatternInfo info;
+        if (!ReadMacroTree(cursor, &tree, &info))
+            return false;
+        ExpandMacroNode(&tree, tree.count, 0, 0, sink);
+        free(tree.nodes);
+        return true;
+    }
+    case PATTERN_UNKNOWN:
+        break;
+    }
+    return false;
+}
+
+// sinks
+
+struct GridTarget {
+    struct BitGrid *grid;
+    int64_t x, y;
+};
+
+static void GridRun(void *context, int64_t const x, int64_t const y, int64_t const length)
+{
+    struct GridTarget const *target = context;
+    struct BitGrid *grid = target->grid;
+    uint64_t *row = grid->cells + (long)(target->y + y) * grid->words;
+
+    // already clipped to the grid by the sink bounds
+    int64_t begin = target->x + x;
+    int64_t const end = begin + length;
+    while (begin < end) {
+        int const shift = (int)(begin % 64);
+        int const count = end - begin < 64 - shift ? (int)(end - begin) : 64 - shift;
+        row[begin / 64] |= (count == 64 ? ~0ull : (1ull << count) - 1) << shift;
+        begin += count;
+    }
+}
+
+bool LoadPatternBits(struct PatternFile const *file, struct BitGrid *grid, int64_t const x, int64_t const y)
+{
+    struct GridTarget target = {grid, x, y};
+    struct PatternSink const sink = {GridRun, &target, -x, -y, grid->width - x, grid->height - y};
+    return DecodePattern(file, &sink);
+}
+
+struct ChunkTarget {
+    struct ChunkWorld *world;
+    int64_t x, y;
+};
+
+static void ChunkRun(void *context, int64_t const x, int64_t const y, int64_t const length)
+{
+    struct ChunkTarget const *target = context;
+    SetChunkRun(target->world, target->x + x, target->y + y, length);
+}
+
+bool LoadPatternChunks(struct PatternFile const *file, struct ChunkWorld *world, int64_t const x, int64_t const y)
+{
+    struct ChunkTarget target = {world, x, y};
+    // chunk coordinates are 32 bit
+    int64_t const limit = (int64_t)INT32_MAX * CHUNK_SIZE;
+    struct PatternSink const sink = {ChunkRun, &target, -limit - x, -limit - y, limit - x, limit - y};
+    return DecodePattern(file, &sink);
+}
+
+bool LoadPatternHashLife(struct PatternFile const *file, struct HashLife *life)
+{
+    if (file->format != PATTERN_MACROCELL) {
+        struct PatternInfo info;
+        if (!ReadPatternInfo(file, &info) || info.width > INT_MAX || info.height > INT_MAX)
+            return false;
+
+        struct BitGrid grid = CreateBitGrid((int)info.height, (int)info.width);
+        if (grid.cells == nullptr)
+            return false;
+        bool const ok = LoadPatternBits(file, &grid, 0, 0);
+        if (ok)
+            LoadHashLifeBits(life, &grid);
+        FreeBitGrid(&grid);
+        return ok;
+    }
+
+    // one hashlife id per node line, the text goes straight into the quadtree
+    struct Cursor cursor = {file->data, file->data + file->size};
+    uint32_t *ids = nullptr;
+    int64_t count = 0, capacity = 0;
+    uint32_t last = 0;
+    struct LifeRule rule;
+    bool ok = true;
+
+    while (ok && cursor.at < cursor.end) {
+        struct MacroNode node;
+        enum MacroLine const line = ReadMacroLine(&cursor, &node, &rule);
+        if (line == MACRO_BAD) {
+            ok = false;
+            break;
+        }
+        if (line != MACRO_LEAF && line != MACRO_NODE)
+            continue;
+
+        if (count + 1 >= capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            uint32_t *grown = realloc(ids, capacity * sizeof *ids);
+            if (grown == nullptr) {
+                ok = false;
+                break;
+            }
+            ids = grown;
+        }
+
+        if (line == MACRO_LEAF) {
+            last = HashLifeLeaf(life, node.leaf);
+        } else {
+            uint32_t children[4];
+            for (int q = 0; q < 4; ++q) {
+                ok = ok && node.children[q] <= count;
+                children[q] = ok && node.children[q] ? ids[node.children[q]] : 0;
+            }
+            last = ok ? HashLifeNode(life, node.level, children[0], children[1], children[2], children[3]) : 0;
+        }
+        ok = ok && last != 0;
+        if (ok)
+            ids[++count] = last;
+    }
+    free(ids);
+
+    // also ends the loading when it failed
+    return SetHashLifeRoot(life, ok ? last : 0) && ok;
+}
+
+// batch
+
+static void LoadPatternJobRange(void *context, int const begin, int const end)
+{
+    struct PatternJob *jobs = context;
+
+    for (int i = begin; i < end; ++i) {
+        struct PatternJob *job = &jobs[i];
+        struct PatternFile file;
+        job->ok = false;
+        job->grid = (struct BitGrid){0};
+
+        if (!OpenPatternFile(job->path, &file))
+            continue;
+
+        if (ReadPatternInfo(&file, &job->info) && job->info.width > 0 && job->info.height > 0
+            && job->info.width <= INT_MAX && job->info.height <= INT_MAX) {
+            job->grid = CreateBitGrid((int)job->info.height, (int)job->info.width);
+            job->ok = job->grid.cells != nullptr && LoadPatternBits(&file, &job->grid, 0, 0);
+        }
+        ClosePatternFile(&file);
+    }
+}
+
+void LoadPatternJobs(struct PatternJob *jobs, int const count, struct WorkerPool *pool)
+{
+    if (pool != nullptr)
+        RunBands(pool, count, LoadPatternJobRange, jobs);
+    else
+        LoadPatternJobRange(jobs, 0, count);
+}
+
+void FreePatternJobs(struct PatternJob *jobs, int const count)
+{
+    for (int i = 0; i < count; ++i)
+        FreeBitGrid(&jobs[i].grid);
+}
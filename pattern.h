@@ -0,0 +1,75 @@
+//
+// RLE, Macrocell and plaintext patterns, read straight from a memory mapped file.
+//
+
+#ifndef GOL_PATTERN_H
+#define GOL_PATTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitlife.h"
+#include "liferule.h"
+#include "chunklife.h"
+#include "hashlife.h"
+#include "workers.h"
+#include "mapfile.h"
+
+enum PatternFormat {
+    PATTERN_UNKNOWN,
+    PATTERN_RLE, // x = 3, y = 3, rule = B3/S23 then bo$2bo$3o!
+    PATTERN_MACROCELL, // [M2] then 8x8 leaves and "level nw ne sw se" nodes
+    PATTERN_PLAINTEXT, // !comments then rows of . and O
+};
+
+struct PatternFile {
+    char const *data; // the mapping, never copied
+    size_t size;
+    enum PatternFormat format;
+    struct MappedFile mapping;
+};
+
+struct PatternInfo {
+    int64_t width; // of the box the pattern was saved in, 2^level for a macrocell
+    int64_t height;
+    struct LifeRule rule;
+    bool has_rule;
+};
+
+// living cells [x, x + length) of row y, in the order of the file
+typedef void (*PatternRun)(void *context, int64_t x, int64_t y, int64_t length);
+
+// cells outside [x0, x1) x [y0, y1) may be left out, macrocell nodes there are never expanded
+struct PatternSink {
+    PatternRun run;
+    void *context;
+    int64_t x0, y0, x1, y1;
+};
+
+bool OpenPatternFile(char const *path, struct PatternFile *file);
+void ClosePatternFile(struct PatternFile *file);
+
+// header only, a plaintext file is scanned once for its size
+bool ReadPatternInfo(struct PatternFile const *file, struct PatternInfo *info);
+bool DecodePattern(struct PatternFile const *file, struct PatternSink const *sink);
+
+// the pattern's top left corner lands on (x, y), cells falling off the grid are dropped
+bool LoadPatternBits(struct PatternFile const *file, struct BitGrid *grid, int64_t x, int64_t y);
+bool LoadPatternChunks(struct PatternFile const *file, struct ChunkWorld *world, int64_t x, int64_t y);
+// macrocell nodes become hashlife nodes as they are read, without expanding them, at (0, 0)
+bool LoadPatternHashLife(struct PatternFile const *file, struct HashLife *life);
+
+// batch loading, each job gets a grid just big enough for its pattern
+struct PatternJob {
+    char const *path;
+    struct BitGrid grid;
+    struct PatternInfo info;
+    bool ok;
+};
+
+// jobs are split between the workers of pool, which may be nullptr
+void LoadPatternJobs(struct PatternJob *jobs, int count, struct WorkerPool *pool);
+void FreePatternJobs(struct PatternJob *jobs, int count);
+
+#endif //GOL_PATTERN_H
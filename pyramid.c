@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "pyramid.h"
+
+bool CreateDensityPyramid(struct DensityPyramid *pyramid, int const height, int const width)
+{
+    // level 0 lines up with the tiles, each level above halves it down to a single block
+    int const rows = (height + TILE_ROWS - 1) / TILE_ROWS << PYRAMID_TILE_LEVEL;
+    int const columns = (width + 63) / 64 << PYRAMID_TILE_LEVEL;
+    int levels = PYRAMID_TILE_LEVEL + 1;
+    for (int r = rows >> PYRAMID_TILE_LEVEL, c = columns >> PYRAMID_TILE_LEVEL; r > 1 || c > 1; ++levels) {
+        r = (r + 1) / 2;
+        c = (c + 1) / 2;
+    }
+
+    *pyramid = (struct DensityPyramid){.height = height, .width = width, .levels = levels};
+    pyramid->level = calloc(levels, sizeof *pyramid->level);
+    if (pyramid->level == nullptr)
+        return false;
+
+    for (int k = 0; k < levels; ++k) {
+        struct PyramidLevel *level = &pyramid->level[k];
+        level->rows = k == 0 ? rows : (pyramid->level[k - 1].rows + 1) / 2;
+        level->columns = k == 0 ? columns : (pyramid->level[k - 1].columns + 1) / 2;
+        size_t const count = (size_t)level->rows * level->columns;
+
+        level->density = calloc(count, 1);
+        if (level->density == nullptr) {
+            FreeDensityPyramid(pyramid);
+            return false;
+        }
+        if (k >= PYRAMID_TILE_LEVEL) {
+            level->queued = calloc(count, 1);
+            level->list = malloc(count * sizeof *level->list);
+            if (level->queued == nullptr || level->list == nullptr) {
+                FreeDensityPyramid(pyramid);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void FreeDensityPyramid(struct DensityPyramid *pyramid)
+{
+    for (int k = 0; pyramid->level != nullptr && k < pyramid->levels; ++k) {
+        free(pyramid->level[k].density);
+        free(pyramid->level[k].queued);
+        free(pyramid->level[k].list);
+    }
+    free(pyramid->level);
+    *pyramid = (struct DensityPyramid){0};
+}
+
+// the four blocks under (row, column), the ones past the edge of the level count as empty
+static uint8_t MeanOfChildren(struct PyramidLevel const *child, int const row, int const column)
+{
+    int sum = 0;
+    for (int i = 2 * row; i < 2 * row + 2 && i < child->rows; ++i)
+        for (int j = 2 * column; j < 2 * column + 2 && j < child->columns; ++j)
+            sum += child->density[(size_t)i * child->columns + j];
+    return (uint8_t)((sum + 2) / 4);
+}
+
+// the blocks of levels 0 to PYRAMID_TILE_LEVEL inside tile (ty, tx)
+static void UpdateTileBlocks(struct DensityPyramid *pyramid, struct BitGrid const *grid, int const ty, int const tx)
+{
+    int counts[8][8] = {0};
+    int const top = ty * TILE_ROWS;
+    int const bottom = top + TILE_ROWS < grid->height ? top + TILE_ROWS : grid->height;
+    for (int y = top; y < bottom; ++y) {
+        uint64_t const word = grid->cells[(long)y * grid->words + tx];
+        if (word == 0)
+            continue;
+        int *row = counts[(y - top) >> PYRAMID_BASE_SHIFT];
+        for (int b = 0; b < 8; ++b)
+            row[b] += PopCount64(word >> 8 * b & 0xff);
+    }
+
+    struct PyramidLevel *base = &pyramid->level[0];
+    for (int i = 0; i < 8; ++i) {
+        uint8_t *density = base->density + (size_t)(ty * 8 + i) * base->columns + tx * 8;
+        for (int j = 0; j < 8; ++j)
+            density[j] = (uint8_t)((counts[i][j] * 255 + 32) / 64);
+    }
+
+    for (int k = 1; k <= PYRAMID_TILE_LEVEL; ++k) {
+        struct PyramidLevel *level = &pyramid->level[k];
+        int const n = 8 >> k;
+        for (int i = ty * n; i < ty * n + n; ++i)
+            for (int j = tx * n; j < tx * n + n; ++j)
+                level->density[(size_t)i * level->columns + j] = MeanOfChildren(&pyramid->level[k - 1], i, j);
+    }
+}
+
+void UpdateDensityPyramid(struct DensityPyramid *pyramid, struct BitGrid const *grid, uint8_t const *changed)
+{
+    struct PyramidLevel *tiles = &pyramid->level[PYRAMID_TILE_LEVEL];
+    int const count = tiles->rows * tiles->columns;
+
+    tiles->count = 0;
+    for (int t = 0; t < count; ++t) {
+        if (changed != nullptr && !changed[t])
+            continue;
+        UpdateTileBlocks(pyramid, grid, t / tiles->columns, t % tiles->columns);
+        tiles->list[tiles->count++] = t;
+    }
+
+    // each level recomputes the parents of what changed below it, once each
+    for (int k = PYRAMID_TILE_LEVEL + 1; k < pyramid->levels; ++k) {
+        struct PyramidLevel const *below = &pyramid->level[k - 1];
+        struct PyramidLevel *level = &pyramid->level[k];
+
+        level->count = 0;
+        for (int i = 0; i < below->count; ++i) {
+            int const block = below->list[i];
+            int const parent = block / below->columns / 2 * level->columns + block % below->columns / 2;
+            if (!level->queued[parent]) {
+                level->queued[parent] = 1;
+                level->list[level->count++] = parent;
+            }
+        }
+        for (int i = 0; i < level->count; ++i) {
+            int const block = level->list[i];
+            level->queued[block] = 0;
+            level->density[block] = MeanOfChildren(below, block / level->columns, block % level->columns);
+        }
+    }
+}
+
+// living cells of the side x side block at (y, x), side below 64
+static int CountBlockCells(struct BitGrid const *grid, int const y, int const x, int const side)
+{
+    int const word = x / 64, shift = x % 64;
+    uint64_t const mask = ((uint64_t)1 << side) - 1;
+    int count = 0;
+    for (int i = y; i < y + side && i < grid->height; ++i) {
+        uint64_t const *row = grid->cells + (long)i * grid->words;
+        uint64_t bits = row[word] >> shift;
+        if (shift + side > 64 && word + 1 < grid->words)
+            bits |= row[word + 1] << (64 - shift);
+        count += PopCount64(bits & mask);
+    }
+    return count;
+}
+
+void RenderDensityView(struct DensityPyramid const *pyramid, struct BitGrid const *grid, struct Viewport const viewport,
+                       int const height, int const width, unsigned char (*texels)[height][width])
+{
+    double const scale = viewport.scale;
+    int const side = scale < 1 ? 1 : (int)scale;
+
+    // the coarsest level whose blocks are no bigger than a pixel
+    int k = 0;
+    while (k + 1 < pyramid->levels && (double)(1 << (PYRAMID_BASE_SHIFT + k + 1)) <= scale)
+        k++;
+    struct PyramidLevel const *level = &pyramid->level[k];
+    int const shift = PYRAMID_BASE_SHIFT + k;
+
+    for (int py = 0; py < height; ++py) {
+        unsigned char *texel = (*texels)[py];
+        double const fy = floor(viewport.y + py * scale);
+        if (fy < 0 || fy >= grid->height) {
+            memset(texel, 0, width);
+            continue;
+        }
+        int const y = (int)fy;
+
+        for (int px = 0; px < width; ++px) {
+            double const fx = floor(viewport.x + px * scale);
+            if (fx < 0 || fx >= grid->width) {
+                texel[px] = 0;
+                continue;
+            }
+            int const x = (int)fx;
+
+            if (side == 1)
+                texel[px] = GetBitCell(grid, y, x) ? 255 : 0;
+            else if (side < 1 << PYRAMID_BASE_SHIFT)
+                texel[px] = (unsigned char)(CountBlockCells(grid, y, x, side) * 255 / (side * side));
+            else
+                texel[px] = level->density[(size_t)(y >> shift) * level->columns + (x >> shift)];
+        }
+    }
+}
@@ -0,0 +1,55 @@
+//
+// Levels of detail of a BitGrid for boards bigger than the screen: the density of 8x8 blocks, 16x16 and so on
+// up to the whole board, kept up to date from the tiles that changed.
+//
+
+#ifndef GOL_PYRAMID_H
+#define GOL_PYRAMID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitlife.h"
+
+#define PYRAMID_BASE_SHIFT 3 // level 0 has blocks of 8x8 cells, level k of 8 << k
+#define PYRAMID_TILE_LEVEL 3 // one block per TileTracker tile
+
+struct PyramidLevel {
+    int rows; // blocks
+    int columns;
+    uint8_t *density; // 0 : no cell alive, 255 : all of them
+
+    // the blocks to recompute on the levels above the tiles
+    uint8_t *queued;
+    int *list;
+    int count;
+};
+
+struct DensityPyramid {
+    int height; // cells
+    int width;
+    int levels;
+    struct PyramidLevel *level;
+};
+
+// the part of the board on screen, in cells
+struct Viewport {
+    double x; // of the top left corner
+    double y;
+    double scale; // cells per pixel, below 1 zooms in
+};
+
+// false when out of memory
+bool CreateDensityPyramid(struct DensityPyramid *pyramid, int height, int width);
+void FreeDensityPyramid(struct DensityPyramid *pyramid);
+
+// the tiles with changed[t] set, numbered as in a TileTracker, and the blocks above them; nullptr : every tile
+void UpdateDensityPyramid(struct DensityPyramid *pyramid, struct BitGrid const *grid, uint8_t const *changed);
+
+// the viewport on a screen of height x width pixels, one density byte per pixel with row 0 at the top;
+// the cells themselves below 8 cells per pixel, the level of the pyramid at the scale above,
+// so the work follows the pixels and not the board
+void RenderDensityView(struct DensityPyramid const *pyramid, struct BitGrid const *grid, struct Viewport viewport,
+                       int height, int width, unsigned char (*texels)[height][width]);
+
+#endif //GOL_PYRAMID_H
@@ -5,12 +5,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+
+#include "rafler.h"
+#include "rng.h"
+
+#ifndef GOL_HEADLESS
+#include "checkpoint.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#endif
 
-#define LOG_RES 7
-#define FIELD_SIZE (1 << LOG_RES)
 #define INNER_RADIUS 7.0
 #define OUTER_RADIUS (3 * INNER_RADIUS)
 #define B1 0.278
@@ -20,6 +26,13 @@
 #define ALPHA_N 0.028
 #define ALPHA_M 0.147
 
+static uint64_t SEED = 1; // of the speckles
+
+#ifndef GOL_HEADLESS
+static char const *CHECKPOINT_FILE = nullptr; // resumed from when present, rewritten every CHECKPOINT_EVERY steps
+static uint64_t CHECKPOINT_EVERY = 500; // 0 : resume only
+#endif
+
 // Buffers
 float fields[2][FIELD_SIZE][FIELD_SIZE] = {0};
 float imaginary_field[FIELD_SIZE][FIELD_SIZE] = {0};
@@ -29,6 +42,7 @@ float M_re_buffer[FIELD_SIZE][FIELD_SIZE], M_im_buffer[FIELD_SIZE][FIELD_SIZE];
 float N_re_buffer[FIELD_SIZE][FIELD_SIZE], N_im_buffer[FIELD_SIZE][FIELD_SIZE];
 int current_field = 0;
 
+#ifndef GOL_HEADLESS
 // Shader sources
 const char* vertex_shader_src = "#version 330 core\n"
                                 "layout(location = 0) in vec2 aPos;\n"
@@ -67,6 +81,8 @@ void check_program_link(GLuint program) {
     }
 }
 
+#endif
+
 // Simulation functions
 float sigma(float x, float a, float alpha) {
     return 1.0f / (1.0f + expf(-4.0f / alpha * (x - a)));
@@ -91,13 +107,16 @@ void initialize_field_with_life() {
 
     // Add speckles of life to the field
     for (int i = 0; i < 200; ++i) {  // Number of speckles
-        int u = rand() % (FIELD_SIZE - (int)INNER_RADIUS);
-        int v = rand() % (FIELD_SIZE - (int)INNER_RADIUS);
+        // draw 0 of speckle i places it, the next ones are its cells
+        uint64_t const place = RandomAt(SEED, (uint64_t)i << 32);
+        int u = (int)((uint32_t)place % (FIELD_SIZE - (int)INNER_RADIUS));
+        int v = (int)((place >> 32) % (FIELD_SIZE - (int)INNER_RADIUS));
 
         for (int x = 0; x < (int)INNER_RADIUS; ++x) {
             for (int y = 0; y < (int)INNER_RADIUS; ++y) {
                 if ((u + x) < FIELD_SIZE && (v + y) < FIELD_SIZE) {
-                    cur_field[u + x][v + y] = (float)rand() / RAND_MAX;  // Random intensity
+                    uint64_t const cell = 1 + (uint64_t)x * (int)INNER_RADIUS + (uint64_t)y;
+                    cur_field[u + x][v + y] = RandomUnit(RandomAt(SEED, (uint64_t)i << 32 | cell));  // Random intensity
                 }
             }
         }
@@ -127,6 +146,7 @@ void step() {
     }
 }
 
+#ifndef GOL_HEADLESS
 // OpenGL rendering
 void render(GLFWwindow* window, GLuint shader_program, GLuint field_texture) {
     glClear(GL_COLOR_BUFFER_BIT);
@@ -195,14 +215,48 @@ int main() {
 
     initialize_field_with_life();
 
+    uint64_t generation = 0, last_checkpoint = 0;
+    struct CheckpointHeader header = MakeCheckpointHeader(CHECKPOINT_RAFLER, FIELD_SIZE, FIELD_SIZE, sizeof fields[0]);
+    header.rng_seed = SEED;
+    struct CheckpointWriter *checkpoints = nullptr;
+    if (CHECKPOINT_FILE != nullptr) {
+        struct Checkpoint resume;
+        if (OpenCheckpoint(CHECKPOINT_FILE, &resume)) {
+            if (resume.header.kind == CHECKPOINT_RAFLER && resume.header.raw_size == header.raw_size
+                && resume.header.height == FIELD_SIZE && resume.header.width == FIELD_SIZE) {
+                memcpy(fields[current_field], resume.payload, sizeof fields[0]);
+                generation = last_checkpoint = resume.header.generation;
+                printf("Resumed %s at step %llu\n", CHECKPOINT_FILE, (unsigned long long)generation);
+            }
+            CloseCheckpoint(&resume);
+        }
+        if (CHECKPOINT_EVERY != 0 && (checkpoints = CreateCheckpointWriter()) == nullptr) {
+            fprintf(stderr, "Failed to start the checkpoint writer\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // Main loop
     while (!glfwWindowShouldClose(window)) {
         step();
+        generation++;
+        if (checkpoints != nullptr && generation - last_checkpoint >= CHECKPOINT_EVERY) {
+            header.generation = generation;
+            if (QueueCheckpoint(checkpoints, CHECKPOINT_FILE, &header, fields[current_field]))
+                last_checkpoint = generation;
+        }
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, FIELD_SIZE, FIELD_SIZE, GL_RED, GL_FLOAT, fields[current_field]);
         render(window, shader_program, field_texture);
         glfwPollEvents();
     }
 
+    if (checkpoints != nullptr) {
+        FreeCheckpointWriter(checkpoints);
+        header.generation = generation;
+        if (generation != last_checkpoint && !WriteCheckpoint(CHECKPOINT_FILE, &header, fields[current_field]))
+            printf("Failed to write the checkpoint %s\n", CHECKPOINT_FILE);
+    }
+
     // Clean up
     glDeleteTextures(1, &field_texture);
     glDeleteProgram(shader_program);
@@ -210,3 +264,4 @@ int main() {
     glfwTerminate();
     return 0;
 }
+#endif
@@ -7,4 +7,10 @@
 
 //int LaunchRafler();
 
+#define LOG_RES 7
+#define FIELD_SIZE (1 << LOG_RES)
+
+void initialize_field_with_life();
+void step();
+
 #endif //GOL_RAFLER_H
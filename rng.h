@@ -0,0 +1,41 @@
+//
+// Counter based random numbers : the value for (seed, counter) needs no state, no order and no lock.
+//
+
+#ifndef GOL_RNG_H
+#define GOL_RNG_H
+
+#include <stdint.h>
+
+// splitmix64 finalizer
+static inline uint64_t RandomMix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// draw counter of the splitmix stream of seed, the same on every machine, libc and thread count
+static inline uint64_t RandomAt(uint64_t const seed, uint64_t const counter)
+{
+    return RandomMix(RandomMix(seed) + (counter + 1) * 0x9E3779B97F4A7C15ull);
+}
+
+// the boards draw one word per 64 cells of a row, cell x of row y is bit x % 64 of it
+static inline uint64_t RandomCellWord(uint64_t const seed, int const y, int const x)
+{
+    return RandomAt(seed, (uint64_t)y << 32 | (uint64_t)(x >> 6));
+}
+
+static inline int RandomCell(uint64_t const seed, int const y, int const x)
+{
+    return (int)(RandomCellWord(seed, y, x) >> (x & 63) & 1);
+}
+
+// 24 bits in [0, 1)
+static inline float RandomUnit(uint64_t const bits)
+{
+    return (float)(bits >> 40) * 0x1p-24f;
+}
+
+#endif //GOL_RNG_H
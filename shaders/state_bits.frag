@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 texCoords;
+
+// the words of a bit row, cell x in bit x % 32 of texel x / 32, row 0 at the top
+uniform usampler2D cells;
+// of the board, the texture is rounded up to whole words
+uniform int width;
+uniform vec3 dead;
+uniform vec3 alive;
+
+void main() {
+    int height = textureSize(cells, 0).y;
+    int y = min(int((1.0 - texCoords.y) * float(height)), height - 1);
+    int x = min(int(texCoords.x * float(width)), width - 1);
+    uint word = texelFetch(cells, ivec2(x / 32, y), 0).r;
+
+    FragColor = vec4(((word >> uint(x % 32)) & 1u) != 0u ? alive : dead, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 texCoords;
+
+// r the cell, g its heat when heated, row 0 at the top
+uniform sampler2D cells;
+uniform bool heated;
+uniform vec3 dead;
+uniform vec3 alive;
+
+void main() {
+    ivec2 size = textureSize(cells, 0);
+    int y = min(int((1.0 - texCoords.y) * float(size.y)), size.y - 1);
+    int x = min(int(texCoords.x * float(size.x)), size.x - 1);
+    vec2 cell = texelFetch(cells, ivec2(x, y), 0).rg;
+    vec3 on = heated ? alive * vec3(1.0, vec2(1.0 - 0.5 * cell.g)) : alive;
+
+    FragColor = vec4(mix(dead, on, cell.r), 1.0);
+}
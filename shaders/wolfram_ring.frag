@@ -0,0 +1,18 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 texCoords;
+
+// one generation per row, written round robin, 255 for a living cell
+uniform sampler2D rows;
+// row of the last generation, drawn at the bottom of the window
+uniform int newest;
+
+void main() {
+    ivec2 size = textureSize(rows, 0);
+    int back = min(int(texCoords.y * float(size.y)), size.y - 1);
+    int column = min(int(texCoords.x * float(size.x)), size.x - 1);
+    float on = texelFetch(rows, ivec2(column, (newest - back + size.y) % size.y), 0).r;
+
+    FragColor = vec4(mix(vec3(0x18 / 255.0), vec3(1.0), on), 1.0);
+}
@@ -0,0 +1,96 @@
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "simulation.h"
+#include "timing.h"
+
+static void SleepSeconds(double const seconds)
+{
+#ifdef _WIN32
+    Sleep((DWORD)(seconds * 1e3));
+#else
+    struct timespec const delay = {(time_t)seconds, (long)((seconds - (double)(time_t)seconds) * 1e9)};
+    nanosleep(&delay, nullptr);
+#endif
+}
+
+static void * SimulationLoop(void *argument)
+{
+    struct SimulationThread *simulation = argument;
+    double const start = WallSeconds();
+
+    uint64_t generation = 0;
+    bool pending = false; // a state the reader was not offered yet
+    while (!atomic_load_explicit(&simulation->stop, memory_order_relaxed)) {
+        if (atomic_exchange_explicit(&simulation->republish, false, memory_order_relaxed))
+            pending = true;
+        // converting a frame costs about a step, only when the reader took the last one;
+        // the generations in between are never converted
+        if (pending && TripleTaken(&simulation->frames)) {
+            simulation->publish(simulation->context, TripleBack(&simulation->frames));
+            PublishTriple(&simulation->frames);
+            pending = false;
+        }
+
+        // against the start rather than the last step, a late generation does not slow the next ones down;
+        // a short sleep at a time so the frame still goes out once the reader is done with the last one
+        if (simulation->rate > 0) {
+            double const ahead = start + (double)generation / simulation->rate - WallSeconds();
+            if (ahead > 0) {
+                SleepSeconds(ahead < .005 ? ahead : .005);
+                continue;
+            }
+        }
+
+        if (!simulation->step(simulation->context)) {
+            // a settled board, the last generation stepped stays the newest one
+            SleepSeconds(.005);
+            continue;
+        }
+        atomic_store_explicit(&simulation->generations, ++generation, memory_order_relaxed);
+        pending = true;
+    }
+    return nullptr;
+}
+
+bool StartSimulation(struct SimulationThread *simulation, size_t const frame_size, double const rate,
+                     bool (*step)(void *context), void (*publish)(void *context, void *frame), void *context)
+{
+    *simulation = (struct SimulationThread){.context = context, .step = step, .publish = publish, .rate = rate};
+    if (!CreateTripleBuffer(&simulation->frames, frame_size))
+        return false;
+
+    publish(context, TripleBack(&simulation->frames));
+    PublishTriple(&simulation->frames);
+
+    if (pthread_create(&simulation->thread, nullptr, SimulationLoop, simulation) != 0) {
+        FreeTripleBuffer(&simulation->frames);
+        return false;
+    }
+    return true;
+}
+
+void StopSimulation(struct SimulationThread *simulation)
+{
+    atomic_store_explicit(&simulation->stop, true, memory_order_relaxed);
+    pthread_join(simulation->thread, nullptr);
+    FreeTripleBuffer(&simulation->frames);
+}
+
+void const * LatestSimulationFrame(struct SimulationThread *simulation, bool *fresh)
+{
+    return TripleFront(&simulation->frames, fresh);
+}
+
+uint64_t SimulationGenerations(struct SimulationThread *simulation)
+{
+    return atomic_load_explicit(&simulation->generations, memory_order_relaxed);
+}
+
+void RepublishSimulation(struct SimulationThread *simulation)
+{
+    atomic_store_explicit(&simulation->republish, true, memory_order_relaxed);
+}
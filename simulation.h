@@ -0,0 +1,40 @@
+//
+// An engine stepped on its own thread, the newest generation published through a triple buffer for the render thread.
+//
+
+#ifndef GOL_SIMULATION_H
+#define GOL_SIMULATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "triple.h"
+
+struct SimulationThread {
+    struct TripleBuffer frames;
+    void *context;
+    bool (*step)(void *context); // one generation, false when there was nothing to step
+    void (*publish)(void *context, void *frame); // the current state into a frame, as the render thread wants it
+    double rate; // generations per second at most, 0 : as fast as it goes
+
+    pthread_t thread;
+    _Atomic bool stop;
+    _Atomic bool republish; // the same generation once more, the way the frames are drawn changed
+    _Atomic uint64_t generations; // stepped so far
+};
+
+// publishes the state it starts from, then steps until StopSimulation; false when it cannot start
+bool StartSimulation(struct SimulationThread *simulation, size_t frame_size, double rate,
+                     bool (*step)(void *context), void (*publish)(void *context, void *frame), void *context);
+// waits for the generation under way, the context belongs to the caller again after that
+void StopSimulation(struct SimulationThread *simulation);
+
+// the newest generation published, nullptr before the first one; fresh when it was not returned before
+void const * LatestSimulationFrame(struct SimulationThread *simulation, bool *fresh);
+uint64_t SimulationGenerations(struct SimulationThread *simulation);
+// publish calls back again before the next step, for when what it renders depends on more than the board
+void RepublishSimulation(struct SimulationThread *simulation);
+
+#endif //GOL_SIMULATION_H
@@ -6,23 +6,58 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifndef GOL_HEADLESS
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 
 #include "util_glfw.h"
-
+#include "simulation.h"
+#endif
+#include "smoothlife.h"
+#include "vectorized.h"
+#include "workers.h"
+#include "rng.h"
+
+#ifndef GOL_HEADLESS
 static int WIDTH = 800;
 static int HEIGHT = 600;
+static int THREADS = 0; // 0 : every hardware thread
+static double GENERATIONS_PER_SECOND = 0; // of the simulation thread, 0 : as fast as it goes whatever the refresh rate
+#endif
 
 static float MIN_PERP = 1.5f;
 static float MAX_PERP = 2.9999f;
 static float MIN_SPAWN = 2.05f;
 static float MAX_SPAWN = 6.1f;
 
-void InitSmoothworld(int height, int width, float (*pixelData)[height][width], unsigned char pattern) {
-    srand(pattern);
+void InitSmoothworldRows(int const height, int const width, float (*pixelData)[height][width], uint64_t const seed,
+                         int const begin, int const end) {
+    for (int y = begin; y < end; ++y) {
+        for (int left = 0; left < width; left += 64) {
+            uint64_t const bits = RandomCellWord(seed, y, left);
+            int const count = width - left < 64 ? width - left : 64;
+            float *cells = &(*pixelData)[y][left];
+            for (int i = 0; i < count; ++i)
+                cells[i] = (float)(bits >> i & 1);
+        }
+    }
+}
+
+struct SmoothSoupBand {
+    int height;
+    int width;
+    void *pixelData;
+    uint64_t seed;
+};
 
-    if(pattern == 0) {
+static void InitSmoothworldBand(void *context, int const begin, int const end)
+{
+    struct SmoothSoupBand const *band = context;
+    InitSmoothworldRows(band->height, band->width, band->pixelData, band->seed, begin, end);
+}
+
+void InitSmoothworld(int height, int width, float (*pixelData)[height][width], uint64_t seed, struct WorkerPool *pool) {
+    if(seed == 0) {
         memset(*pixelData, 0, sizeof *pixelData);
         // glider
         (*pixelData)[0][0] = 1;
@@ -30,12 +65,11 @@ void InitSmoothworld(int height, int width, float (*pixelData)[height][width], u
         (*pixelData)[1][2] = 1;
         (*pixelData)[2][0] = 1;
         (*pixelData)[2][1] = 1;
+    } else if (pool != nullptr) {
+        struct SmoothSoupBand band = {height, width, pixelData, seed};
+        RunBands(pool, height, InitSmoothworldBand, &band);
     } else {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; x++) {
-                (*pixelData)[y][x] = rand() & 1;
-            }
-        }
+        InitSmoothworldRows(height, width, pixelData, seed, 0, height);
     }
 }
 
@@ -63,7 +97,7 @@ void IterateSmoothworld(
     memcpy(pixelColors, newPixelColors, sizeof *newPixelColors);
 }
 
-static float conway_rule(float current_state, float moore_number,
+[[maybe_unused]] static float conway_rule(float current_state, float moore_number,
                          const float min_perp, const float max_perp, const float min_spawn, const float max_spawn) {
     if (current_state && (moore_number >= min_perp && moore_number <= max_perp))
         return current_state;
@@ -73,26 +107,91 @@ static float conway_rule(float current_state, float moore_number,
     return 0;
 }
 
+struct SmoothBand {
+    int height;
+    int width;
+    void *pixelData; // float[height][width]
+    void *newPixelData;
+};
+
+void StepSmoothWorldRows(int const height, int const width, float const (*pixelData)[height][width],
+                         float (*newPixelData)[height][width], int const begin, int const end)
+{
+    IterateSmoothworldVectorizedRows(height, width, pixelData, newPixelData,
+                                     MIN_PERP, MAX_PERP, MIN_SPAWN, MAX_SPAWN, begin, end);
+}
+
+static void IterateSmoothworldBand(void *context, int const begin, int const end)
+{
+    struct SmoothBand const *band = context;
+
+    StepSmoothWorldRows(band->height, band->width, band->pixelData, band->newPixelData, begin, end);
+}
+
+void StepSmoothWorld(int const height, int const width, float const (*pixelData)[height][width],
+                     float (*newPixelData)[height][width], struct WorkerPool *pool)
+{
+    // conway_rule on whole vectors, IterateSmoothworld stays the path for other rules
+    struct SmoothBand band = {height, width, (void *)pixelData, newPixelData};
+    RunBands(pool, height, IterateSmoothworldBand, &band);
+}
+
+#ifndef GOL_HEADLESS
+
+// owned by the simulation thread until StopSimulation
+struct SmoothRun {
+    void *pixelData; // float[HEIGHT][WIDTH]
+    void *newPixelData;
+    struct WorkerPool *pool;
+};
+
+static bool StepSmoothRun(void *context)
+{
+    struct SmoothRun *run = context;
+    StepSmoothWorld(HEIGHT, WIDTH, run->pixelData, run->newPixelData, run->pool);
+
+    // intervertit les buffers au lieu de recopier la grille
+    void *tmp = run->pixelData;
+    run->pixelData = run->newPixelData;
+    run->newPixelData = tmp;
+    return true;
+}
+
+static void PublishSmoothRun(void *context, void *frame)
+{
+    struct SmoothRun const *run = context;
+    ConvertIntensityToTexels(HEIGHT, WIDTH, run->pixelData, frame);
+}
+
 void LaunchSmoothWorld(unsigned char seed)
 {
-    float (*pixelColors)[HEIGHT*WIDTH*3] = malloc(sizeof (float[HEIGHT*WIDTH*3]));
     float (*pixelData)[HEIGHT][WIDTH] = malloc(sizeof (float[HEIGHT][WIDTH]));
     float (*newPixelData)[HEIGHT][WIDTH] = malloc(sizeof (float[HEIGHT][WIDTH]));
 
-    if(pixelColors == NULL || newPixelData == NULL || pixelData == NULL) {
+    if(newPixelData == NULL || pixelData == NULL) {
         fprintf(stderr, "fail to generate color buffer on CPU\n");
         exit(EXIT_FAILURE);
     }
 
-    InitSmoothworld(HEIGHT, WIDTH, pixelData, seed);
-
-    GLFWwindow* window = OpenWindow("GOL", WIDTH, HEIGHT, false, false);
-    GLuint program, VAO, VBO;
-    GLint vpos_location, vcol_location;
+    struct WorkerPool *pool = CreateWorkerPool(THREADS);
+    if (pool == NULL) {
+        fprintf(stderr, "fail to start the worker pool\n");
+        exit(EXIT_FAILURE);
+    }
 
-    LoadShaders(&program, &vpos_location, &vcol_location);
+    InitSmoothworld(HEIGHT, WIDTH, pixelData, seed, pool);
 
-    long offset = GeneratePixelData(HEIGHT, WIDTH, pixelColors, vpos_location, vcol_location, &VAO, &VBO);
+    GLFWwindow* window = OpenWindow("GOL", WIDTH, HEIGHT, false, false);
+    float const min = 0x18/255.f;
+    struct StateView view;
+    CreateStateView(&view, STATE_INTENSITY, HEIGHT, WIDTH, (struct StatePalette){{min, min, min}, {min + 1, min, min}});
+
+    struct SmoothRun run = {pixelData, newPixelData, pool};
+    struct SimulationThread simulation;
+    if (!StartSimulation(&simulation, view.size, GENERATIONS_PER_SECOND, StepSmoothRun, PublishSmoothRun, &run)) {
+        fprintf(stderr, "fail to start the simulation thread\n");
+        exit(EXIT_FAILURE);
+    }
 
     glClearColor(0x18/255.f, 0x18/255.f,0x18/255.f, 1);
 
@@ -106,32 +205,25 @@ void LaunchSmoothWorld(unsigned char seed)
 
         glClear(GL_COLOR_BUFFER_BIT);
 
-        IterateSmoothworld(HEIGHT, WIDTH, pixelData, newPixelData, conway_rule,
-                           MIN_PERP, MAX_PERP, MIN_SPAWN, MAX_SPAWN);
-        int k = 0;
-        for (int i = 0; i < HEIGHT*WIDTH; ++i) {
-            float strength = (*pixelData)[i / HEIGHT][i % WIDTH];
-            float min = 0x18/255.f;
-            float r = min + strength;
-            float g = min;
-            float b = min;
-
-            (*pixelColors)[k++] =r;
-            (*pixelColors)[k++] =g;
-            (*pixelColors)[k++] =b;
-        }
-        RenderPixels(WIDTH*HEIGHT, program, VAO, HEIGHT, WIDTH, offset, pixelColors);
+        bool fresh;
+        void const *frame = LatestSimulationFrame(&simulation, &fresh);
+        if (fresh)
+            UploadStateView(&view, frame);
+        DrawStateView(&view);
+        PrintStateUploads(&view);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    free(pixelColors);
-    free(pixelData);
-    free(newPixelData);
+    StopSimulation(&simulation);
+    FreeStateView(&view);
+    free(run.pixelData);
+    free(run.newPixelData);
+    FreeWorkerPool(pool);
 
     glfwDestroyWindow(window);
 
     glfwTerminate();
 }
-
+#endif
@@ -5,8 +5,23 @@
 #ifndef GOL_SMOOTHLIFE_H
 #define GOL_SMOOTHLIFE_H
 
+#include <stdint.h>
+
+#include "workers.h"
+
 void LaunchSmoothWorld(unsigned char seed);
 
+// seed 0 is a glider, a soup of that seed otherwise, the rows split over pool unless it is nullptr
+void InitSmoothworld(int height, int width, float (*pixelData)[height][width], uint64_t seed, struct WorkerPool *pool);
+// rows [begin, end) of the soup, one draw per 64 cells
+void InitSmoothworldRows(int height, int width, float (*pixelData)[height][width], uint64_t seed, int begin, int end);
+// one generation of conway_rule with the MIN/MAX thresholds, banded over pool
+void StepSmoothWorld(int height, int width, float const (*pixelData)[height][width],
+                     float (*newPixelData)[height][width], struct WorkerPool *pool);
+// rows [begin, end) of it on the calling thread
+void StepSmoothWorldRows(int height, int width, float const (*pixelData)[height][width],
+                         float (*newPixelData)[height][width], int begin, int end);
+
 
 
 #endif //GOL_SMOOTHLIFE_H
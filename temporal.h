@@ -0,0 +1,48 @@
+//
+// Temporal blocking of the float Conway kernels: a tile and its halo stepped several generations in cache.
+//
+
+#ifndef GOL_TEMPORAL_H
+#define GOL_TEMPORAL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct LifeRule;
+
+struct TemporalBlocking {
+    int generations; // per pass over the board, 1 : no blocking
+    int rows; // of a tile, stepped along with generations cells of halo on each side
+    int columns;
+};
+
+// a tile with its halo and the next generation of it for each worker, allocated once per board
+struct TemporalScratch {
+    int workers;
+    size_t cells; // of one tile with its halo
+    float *memory; // workers x 2 tiles of cells x (value, heat)
+};
+
+// L2 of one core, from sysconf where it knows it, 1 MiB otherwise
+size_t CacheSize(void);
+
+// the tiles that fit in cache for that board; generations 0 picks them from the cache size,
+// it stays 1 while both boards fit in L3, or in 128 MiB of it
+struct TemporalBlocking ChooseTemporalBlocking(int height, int width, int generations);
+
+// room for blocking on every worker of a pool, false when out of memory
+bool CreateTemporalScratch(struct TemporalScratch *scratch, struct TemporalBlocking blocking, int workers);
+void FreeTemporalScratch(struct TemporalScratch *scratch);
+
+// generations of rule from pixelData to newPixelData on the tiles [begin, end), numbered row by row,
+// IterateConwayVectorizedRows when rule is nullptr; each tile is read and written once,
+// in the tiles of scratch that belong to worker
+void IterateConwayBlocks(int height, int width, float const (*pixelData)[height][width][2],
+                         float (*newPixelData)[height][width][2], struct LifeRule const *rule,
+                         struct TemporalBlocking blocking, int generations,
+                         struct TemporalScratch const *scratch, int worker, int begin, int end);
+
+// tiles of the board, for RunBands
+int TemporalTiles(int height, int width, struct TemporalBlocking blocking);
+
+#endif //GOL_TEMPORAL_H
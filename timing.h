@@ -0,0 +1,21 @@
+//
+// Wall clock for timing runs, clock() adds up the CPU time of every worker.
+//
+
+#ifndef GOL_TIMING_H
+#define GOL_TIMING_H
+
+#include <time.h>
+
+static inline double WallSeconds(void)
+{
+    struct timespec now;
+#ifdef _WIN32
+    timespec_get(&now, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+#endif //GOL_TIMING_H
@@ -0,0 +1,52 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "triple.h"
+
+bool CreateTripleBuffer(struct TripleBuffer *buffer, size_t const size)
+{
+    *buffer = (struct TripleBuffer){.back = 0, .middle = 1, .front = 2};
+    // a cache line between two frames, the threads never write the same one
+    size_t const stride = (size + 63) & ~(size_t)63;
+    buffer->memory = malloc(3 * stride);
+    if (buffer->memory == nullptr)
+        return false;
+    for (int i = 0; i < 3; ++i)
+        buffer->frames[i] = buffer->memory + i * stride;
+    return true;
+}
+
+void FreeTripleBuffer(struct TripleBuffer *buffer)
+{
+    free(buffer->memory);
+    buffer->memory = nullptr;
+}
+
+void * TripleBack(struct TripleBuffer const *buffer)
+{
+    return buffer->frames[buffer->back];
+}
+
+void PublishTriple(struct TripleBuffer *buffer)
+{
+    // release : the frame is written before the reader may see its index, acquire : the one we get back is not read anymore
+    int const old = atomic_exchange_explicit(&buffer->middle, buffer->back | TRIPLE_FRESH, memory_order_acq_rel);
+    buffer->back = old & ~TRIPLE_FRESH;
+}
+
+bool TripleTaken(struct TripleBuffer *buffer)
+{
+    return !(atomic_load_explicit(&buffer->middle, memory_order_relaxed) & TRIPLE_FRESH);
+}
+
+void const * TripleFront(struct TripleBuffer *buffer, bool *fresh)
+{
+    *fresh = false;
+    if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & TRIPLE_FRESH) {
+        int const old = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel);
+        buffer->front = old & ~TRIPLE_FRESH;
+        buffer->seen = true;
+        *fresh = true;
+    }
+    return buffer->seen ? buffer->frames[buffer->front] : nullptr;
+}
@@ -0,0 +1,36 @@
+//
+// Triple buffer handing frames from one thread to another, neither side ever waits on the other.
+//
+
+#ifndef GOL_TRIPLE_H
+#define GOL_TRIPLE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// the writer fills back while the reader holds front, middle is the newest complete frame between them
+struct TripleBuffer {
+    unsigned char *memory;
+    void *frames[3];
+    int back; // the writer's
+    int front; // the reader's
+    bool seen; // the reader got a frame once
+    _Atomic int middle; // index of the frame, TRIPLE_FRESH set until the reader takes it
+};
+
+#define TRIPLE_FRESH 4
+
+// three frames of size bytes, false when they cannot be allocated
+bool CreateTripleBuffer(struct TripleBuffer *buffer, size_t size);
+void FreeTripleBuffer(struct TripleBuffer *buffer);
+
+// writer : the frame to fill, then published as the newest one; a frame the reader did not take is reused
+void * TripleBack(struct TripleBuffer const *buffer);
+void PublishTriple(struct TripleBuffer *buffer);
+// writer : the reader took the newest frame already, one published now would not replace a frame never read
+bool TripleTaken(struct TripleBuffer *buffer);
+
+// reader : the newest frame published, nullptr before the first one; fresh when it was not returned before
+void const * TripleFront(struct TripleBuffer *buffer, bool *fresh);
+
+#endif //GOL_TRIPLE_H
@@ -4,10 +4,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 
+#include "util_glfw.h"
+
 static void error_callback(int error, const char* description)
 {
     fprintf(stderr, "Error %d : %s\n", error, description);
@@ -97,8 +100,6 @@ GLFWwindow* OpenWindow(const char * title, int width, int height, bool is_fullsc
 
     glfwSwapInterval(has_vertical_sync ? 1 : 0);
 
-    glEnable(GL_PROGRAM_POINT_SIZE);
-
     return window;
 }
 
@@ -114,139 +115,204 @@ char * GetShaderSource_freeme(const char * filename, long * length) {
     return shader_text;
 }
 
-void LoadShaders(GLuint * program, GLint * vpos_location, GLint * vcol_location) {
-
-    GLuint vertex_shader, fragment_shader;
-
-    {
-        vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-        long vert_size;
-        char *vertex_shader_text = GetShaderSource_freeme("shaders/pixel_screen.vert", &vert_size);
-        const char *sourceStrings[] = {vertex_shader_text};
-        const int lengthStrings[] = {(GLint) vert_size};
-
-        glShaderSource(vertex_shader, 1, sourceStrings, lengthStrings);
-        glCompileShader(vertex_shader);
-
-        free(vertex_shader_text);
-
-        GLint compiled;
-        glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &compiled);
-        if(!compiled) {
-            char infoLog[512];
-            glGetShaderInfoLog(vertex_shader, 512, nullptr, infoLog);
-            fprintf(stderr, "ERROR: Vertex Shader compilation failed\n%s\n", infoLog);
-        } else {
-            fputs("Vertex Shader compilation succeed\n", stderr);
-        }
-    }
-
-    {
-        fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-
-        long frag_size;
-        char *fragment_shader_text = GetShaderSource_freeme("shaders/simple.frag", &frag_size);
-        const char* sourceStrings[] = { fragment_shader_text };
-        const int lengthStrings[] = { (GLint)frag_size };
-
-        glShaderSource(fragment_shader, 1, sourceStrings, lengthStrings);
-        glCompileShader(fragment_shader);
-
-        free(fragment_shader_text);
-
-        GLint compiled;
-        glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &compiled);
-        if(!compiled) {
-            char infoLog[512];
-            glGetShaderInfoLog(fragment_shader, 512, nullptr, infoLog);
-            fprintf(stderr, "ERROR: Fragment Shader compilation failed\n%s\n", infoLog);
-
-        } else {
-            fputs("Fragment Shader compilation succeed\n", stderr);
-
-        }
+static GLuint CompileShaderFile(GLenum const type, const char *filename)
+{
+    long size;
+    char *text = GetShaderSource_freeme(filename, &size);
+    const char *sourceStrings[] = {text};
+    const int lengthStrings[] = {(GLint)size};
+
+    GLuint const shader = glCreateShader(type);
+    glShaderSource(shader, 1, sourceStrings, lengthStrings);
+    glCompileShader(shader);
+    free(text);
+
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        fprintf(stderr, "ERROR: %s compilation failed\n%s\n", filename, infoLog);
     }
+    return shader;
+}
 
-    *program = glCreateProgram();
-    glAttachShader(*program, vertex_shader);
-    glAttachShader(*program, fragment_shader);
-    glLinkProgram(*program);
-
-    int success;
-    char infoLog[512];
-    glGetProgramiv(*program, GL_LINK_STATUS, &success);
+GLuint LoadProgram(const char *vertex_file, const char *fragment_file)
+{
+    GLuint const vertex_shader = CompileShaderFile(GL_VERTEX_SHADER, vertex_file);
+    GLuint const fragment_shader = CompileShaderFile(GL_FRAGMENT_SHADER, fragment_file);
+
+    GLuint const program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(*program, 512, nullptr, infoLog);
-        fprintf(stderr, "ERROR: Shader linking failed\n%s\n", infoLog);
-    } else {
-        fputs("Shader linking succeed\n", stderr);
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        fprintf(stderr, "ERROR: linking %s and %s failed\n%s\n", vertex_file, fragment_file, infoLog);
     }
-
-    //mvp_location = glGetUniformLocation(program, "MVP");
-    *vpos_location = glGetAttribLocation(*program, "vPos");
-    *vcol_location = glGetAttribLocation(*program, "vCol");
-
-    //fprintf(stderr, "pos %d\ncolor %d\n", vpos_location, vcol_location);
-
-    GLenum err = glGetError();
-
-    fprintf(stderr, "erreur %d\n", err);
-
+    return program;
 }
 
-
-// Define your pixels as points (positions in normalized coordinates, colors)
-int GeneratePixelData(int const height, int const width, float const (*pixelColorData)[height*width*3],
-                      int const pos_index, int const col_index, GLuint *VAO, GLuint * VBO) {
-
-    float (*pixelPosData)[height*width * 2] = malloc(sizeof (float[height*width*2]));
-
-    int j = 0;
-    int k = 0;
-    // Example: Add points with different colors and positions
-    for (int i = 0; i < height*width; ++i) {
-        float x = (float)(i % width) / (float)width * 2.0f - 1.0f;
-        float y = (float)(i / width) / (float)height * 2.0f - 1.0f;
-
-        (*pixelPosData)[j++] =x;
-        (*pixelPosData)[j++] =-y;
-    }
+// the whole viewport as a triangle strip, aPos at location 0 like vertex_to_tex.vert wants
+void CreateScreenQuad(GLuint *VAO, GLuint *VBO)
+{
+    static float const corners[] = {-1, -1, 1, -1, -1, 1, 1, 1};
 
     glGenVertexArrays(1, VAO);
     glGenBuffers(1, VBO);
-
     glBindVertexArray(*VAO);
     glBindBuffer(GL_ARRAY_BUFFER, *VBO);
-    //glBufferData(GL_ARRAY_BUFFER, size* sizeof(float), pixelData, GL_STATIC_DRAW);
-    glBufferData(GL_ARRAY_BUFFER, (long)(sizeof *pixelPosData + sizeof *pixelColorData), nullptr, GL_STREAM_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, (long)(sizeof *pixelPosData), pixelPosData);
-    glBufferSubData(GL_ARRAY_BUFFER, (long)(sizeof *pixelPosData), (long)(sizeof *pixelColorData), pixelColorData);
+    glBufferData(GL_ARRAY_BUFFER, sizeof corners, corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(0);
+}
 
-    // Position attribute
-    glVertexAttribPointer(pos_index, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(pos_index);
+static GLint const STATE_INTERNAL_FORMATS[] = {GL_R32UI, GL_RG8, GL_R8};
+static GLenum const STATE_FORMATS[] = {GL_RED_INTEGER, GL_RG, GL_RED};
+static GLenum const STATE_TYPES[] = {GL_UNSIGNED_INT, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE};
+static size_t const STATE_TEXEL_SIZES[] = {4, 2, 1};
 
-    // Color attribute
-    glVertexAttribPointer(col_index, 3, GL_FLOAT, GL_FALSE, 0, (void*)(sizeof *pixelPosData));
-    glEnableVertexAttribArray(col_index);
+// texels of a row, a bit row rounded up to whole 64 cell words
+static int StateTexels(enum StateFormat const format, int const width)
+{
+    return format == STATE_BITS ? (width + 63) / 64 * 2 : width;
+}
 
-    free(pixelPosData); // ?
+void CreateStateView(struct StateView *view, enum StateFormat const format, int const height, int const width,
+                     struct StatePalette const palette)
+{
+    *view = (struct StateView){
+        .format = format, .height = height, .width = width,
+        .size = (size_t)StateTexels(format, width) * height * STATE_TEXEL_SIZES[format],
+        .last_print = glfwGetTime(),
+    };
+    view->program = LoadProgram("shaders/vertex_to_tex.vert",
+                                format == STATE_BITS ? "shaders/state_bits.frag" : "shaders/state_cells.frag");
+    CreateScreenQuad(&view->VAO, &view->VBO);
+
+    glGenTextures(1, &view->texture);
+    glBindTexture(GL_TEXTURE_2D, view->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, STATE_INTERNAL_FORMATS[format], StateTexels(format, width), height, 0,
+                 STATE_FORMATS[format], STATE_TYPES[format], nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenBuffers(STATE_UPLOAD_BUFFERS, view->buffers);
+    for (int i = 0; i < STATE_UPLOAD_BUFFERS; ++i) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, view->buffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)view->size, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glUseProgram(view->program);
+    glUniform3fv(glGetUniformLocation(view->program, "dead"), 1, palette.dead);
+    glUniform3fv(glGetUniformLocation(view->program, "alive"), 1, palette.alive);
+    if (format == STATE_BITS)
+        glUniform1i(glGetUniformLocation(view->program, "width"), width);
+    else
+        glUniform1i(glGetUniformLocation(view->program, "heated"), format == STATE_ALIVE_HEAT);
+}
+
+void * MapStateUpload(struct StateView *view)
+{
+    double const start = glfwGetTime();
+    GLsync *fence = &view->fences[view->next];
+    if (*fence != nullptr) {
+        GLenum status;
+        do
+            status = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        while (status == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(*fence);
+        *fence = nullptr;
+    }
+
+    // the fence says the GPU is done with it, no need for the driver to check again
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, view->buffers[view->next]);
+    void *state = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)view->size,
+                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (state == nullptr) {
+        fprintf(stderr, "fail to map the state buffer\n");
+        exit(EXIT_FAILURE);
+    }
 
-    return sizeof *pixelPosData;
+    double const blocked = glfwGetTime() - start;
+    view->blocked += blocked;
+    if (blocked > view->worst_blocked)
+        view->worst_blocked = blocked;
+    view->uploads++;
+    return state;
 }
 
-void RenderPixels(int const size, GLuint const shaderProgram, GLuint VAO,
-                  int const height, int const width, long const offset, float const (*pixelColorData)[height*width*3]) {
+void FinishStateUpload(struct StateView *view)
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, view->buffers[view->next]);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // from the buffer bound, at offset 0
+    glBindTexture(GL_TEXTURE_2D, view->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, StateTexels(view->format, view->width), view->height,
+                    STATE_FORMATS[view->format], STATE_TYPES[view->format], nullptr);
+    view->fences[view->next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    view->next = (view->next + 1) % STATE_UPLOAD_BUFFERS;
+}
 
-    // Render points
-    glBufferSubData(GL_ARRAY_BUFFER, offset, (long)(sizeof *pixelColorData), pixelColorData);
+void UploadStateView(struct StateView *view, void const *state)
+{
+    memcpy(MapStateUpload(view), state, view->size);
+    FinishStateUpload(view);
+}
+
+void ConvertIntensityToTexels(int const height, int const width, float const (*field)[height][width],
+                              unsigned char (*texels)[height][width])
+{
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float const intensity = (*field)[y][x];
+            (*texels)[y][x] = (unsigned char)(intensity >= 1 ? 255 : intensity <= 0 ? 0 : intensity * 255 + .5f);
+        }
+    }
+}
 
-    glUseProgram(shaderProgram);
-    glDrawArrays(GL_POINTS, 0, size);
+void PrintStateUploads(struct StateView *view)
+{
+    double const now = glfwGetTime();
+    if (now - view->last_print < 1 || view->uploads == 0)
+        return;
+
+    printf("upload blocked %.1f us per frame, %.1f us at worst, %d frames\n",
+           view->blocked / view->uploads * 1e6, view->worst_blocked * 1e6, view->uploads);
+    view->blocked = view->worst_blocked = 0;
+    view->uploads = 0;
+    view->last_print = now;
+}
 
-    // Cleanup
+void DrawStateView(struct StateView const *view)
+{
+    glUseProgram(view->program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, view->texture);
+    glBindVertexArray(view->VAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
 
-    // glBindVertexArray(0);
-    // glDeleteVertexArrays(1, &VAO);
-    // glDeleteBuffers(1, &VBO);
+void FreeStateView(struct StateView *view)
+{
+    for (int i = 0; i < STATE_UPLOAD_BUFFERS; ++i)
+        if (view->fences[i] != nullptr)
+            glDeleteSync(view->fences[i]);
+    glDeleteBuffers(STATE_UPLOAD_BUFFERS, view->buffers);
+    glDeleteTextures(1, &view->texture);
+    glDeleteBuffers(1, &view->VBO);
+    glDeleteVertexArrays(1, &view->VAO);
+    glDeleteProgram(view->program);
 }
@@ -11,14 +11,78 @@ GetShaderSource_freeme(const char * filename, long * length);
 GLFWwindow*
 OpenWindow(const char * title, int width, int height, bool is_fullscreen, bool has_vertical_sync);
 
+// both files from shaders/, compile and link errors are printed
+GLuint
+LoadProgram(const char * vertex_file, const char * fragment_file);
+
+void
+CreateScreenQuad(GLuint * VAO, GLuint * VBO);
+
+// what a state texture holds per cell, uploaded as the engine keeps it or close to it
+enum StateFormat {
+    STATE_BITS, // the rows of a BitGrid, 64 cells per word, a GL_R32UI texture
+    STATE_ALIVE_HEAT, // two bytes per cell, 255 alive and the heat, GL_RG8
+    STATE_INTENSITY, // one byte per cell, GL_R8
+};
+
+struct StatePalette {
+    float dead[3];
+    float alive[3]; // a cell at full intensity, the heat of STATE_ALIVE_HEAT fades its green and blue down to half
+};
+
+#define STATE_UPLOAD_BUFFERS 3
+
+// the board in one texture drawn on a screen quad, the palette applied by the fragment shader;
+// it goes up through a ring of pixel buffers, the next state is written while the GPU still copies the last ones
+struct StateView {
+    enum StateFormat format;
+    int height;
+    int width;
+    GLuint program;
+    GLuint texture;
+    GLuint VAO;
+    GLuint VBO;
+
+    size_t size; // bytes of one state
+    GLuint buffers[STATE_UPLOAD_BUFFERS];
+    GLsync fences[STATE_UPLOAD_BUFFERS]; // passed once the texture holds the buffer, nullptr : never used
+    int next;
+
+    // seconds spent waiting on the fences, since the last PrintStateUploads
+    double blocked;
+    double worst_blocked; // of a single upload
+    int uploads;
+    double last_print;
+};
+
+void
+CreateStateView(struct StateView * view, enum StateFormat format, int height, int width, struct StatePalette palette);
+
+// size bytes to fill with the next state, height rows of the format with row 0 at the top of the window;
+// waits only when the GPU still reads all the buffers, write only since the memory may be uncached
+void *
+MapStateUpload(struct StateView * view);
+
+// queues the copy of the mapped state into the texture, returns without waiting for it
+void
+FinishStateUpload(struct StateView * view);
+
+// MapStateUpload, a copy of state and FinishStateUpload
+void
+UploadStateView(struct StateView * view, void const * state);
+
+// a field of intensities in [0, 1] as one byte per cell, for STATE_INTENSITY; clamped outside of it
+void
+ConvertIntensityToTexels(int height, int width, float const (*field)[height][width], unsigned char (*texels)[height][width]);
+
+// the time blocked per upload, once a second at most
+void
+PrintStateUploads(struct StateView * view);
+
 void
-LoadShaders(GLuint * program, GLint * vpos_location, GLint * vcol_location);
+DrawStateView(struct StateView const * view);
 
-int
-GeneratePixelData(int height, int width, float (*pixelColorData)[height*width*3],
-                      int pos_index, int col_index, GLuint *VAO, GLuint * VBO);
 void
-RenderPixels(int size, GLuint shaderProgram, GLuint VAO,
-                  int height, int width, long offset, float (*pixelColorData)[height*width*3]);
+FreeStateView(struct StateView * view);
 
 #endif //GOL_UTIL_GLFW_H
@@ -0,0 +1,346 @@
+#include <string.h>
+
+#include "vectorized.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GOL_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+struct SmoothRule {
+    float min_perp, max_perp, min_spawn, max_spawn;
+};
+
+// rows are flat, 2 floats (value, heat) per Conway cell and 1 float per SmoothWorld cell
+typedef void (*ConwayRowKernel)(float const *up, float const *row, float const *down, float *out, int width);
+typedef void (*SmoothRowKernel)(float const *up, float const *row, float const *down, float *out, int width,
+                                struct SmoothRule rule);
+
+// scalar cell, same operation order as IterateConway so the sums match bit for bit
+static inline void ConwayCell(float const *up, float const *row, float const *down, float *out,
+                              int const width, int const x)
+{
+    int const l = x == 0 ? width - 1 : x - 1;
+    int const r = x == width - 1 ? 0 : x + 1;
+
+    float const moore = up[2*l] + up[2*x] + up[2*r]
+                      + row[2*l] + row[2*r]
+                      + down[2*l] + down[2*x] + down[2*r];
+    float const value = row[2*x];
+    float const heat = row[2*x + 1];
+
+    if (value && (moore == 2 || moore == 3)) {
+        out[2*x] = 1;
+        out[2*x + 1] = heat * .99f;
+    } else if (!value && moore == 3) {
+        out[2*x] = 1;
+        out[2*x + 1] = 1;
+    } else {
+        out[2*x] = 0;
+        out[2*x + 1] = 0;
+    }
+}
+
+static inline void SmoothCell(float const *up, float const *row, float const *down, float *out,
+                              int const width, int const x, struct SmoothRule const rule)
+{
+    int const l = x == 0 ? width - 1 : x - 1;
+    int const r = x == width - 1 ? 0 : x + 1;
+
+    float const moore = up[l] + up[x] + up[r]
+                      + row[l] + row[r]
+                      + down[l] + down[x] + down[r];
+    float const value = row[x];
+
+    if (value && (moore >= rule.min_perp && moore <= rule.max_perp))
+        out[x] = value;
+    else if (!value && (moore >= rule.min_spawn && moore <= rule.max_spawn))
+        out[x] = 1;
+    else
+        out[x] = 0;
+}
+
+static void ConwayRowScalar(float const *up, float const *row, float const *down, float *out, int const width)
+{
+    for (int x = 0; x < width; x++)
+        ConwayCell(up, row, down, out, width, x);
+}
+
+static void SmoothRowScalar(float const *up, float const *row, float const *down, float *out, int const width,
+                            struct SmoothRule const rule)
+{
+    for (int x = 0; x < width; x++)
+        SmoothCell(up, row, down, out, width, x, rule);
+}
+
+#ifdef GOL_X86_KERNELS
+
+// 4 cells per vector, value in the even lanes and heat in the odd ones
+__attribute__((target("avx2")))
+static void ConwayRowAvx2(float const *up, float const *row, float const *down, float *out, int const width)
+{
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const one = _mm256_set1_ps(1);
+    __m256 const two = _mm256_set1_ps(2);
+    __m256 const three = _mm256_set1_ps(3);
+    __m256 const decay = _mm256_set1_ps(.99f);
+
+    ConwayCell(up, row, down, out, width, 0);
+
+    int x = 1;
+    for (; x + 4 < width; x += 4) {
+        float const *u = up + 2*x, *c = row + 2*x, *d = down + 2*x;
+
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(u - 2), _mm256_loadu_ps(u));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(u + 2));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(c - 2));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(c + 2));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(d - 2));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(d));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(d + 2));
+
+        __m256 const center = _mm256_loadu_ps(c);
+        __m256 const moore = _mm256_moveldup_ps(sum);
+        __m256 const value = _mm256_moveldup_ps(center);
+        __m256 const heat = _mm256_movehdup_ps(center);
+
+        __m256 const alive = _mm256_cmp_ps(value, zero, _CMP_NEQ_UQ);
+        __m256 const is3 = _mm256_cmp_ps(moore, three, _CMP_EQ_OQ);
+        __m256 const is2or3 = _mm256_or_ps(_mm256_cmp_ps(moore, two, _CMP_EQ_OQ), is3);
+        __m256 const survive = _mm256_and_ps(alive, is2or3);
+        __m256 const birth = _mm256_andnot_ps(alive, is3);
+
+        __m256 const newValue = _mm256_and_ps(_mm256_or_ps(survive, birth), one);
+        __m256 const newHeat = _mm256_or_ps(
+                _mm256_and_ps(survive, _mm256_mul_ps(heat, decay)),
+                _mm256_and_ps(birth, one));
+
+        _mm256_storeu_ps(out + 2*x, _mm256_blend_ps(newValue, newHeat, 0xAA));
+    }
+
+    for (; x < width; x++)
+        ConwayCell(up, row, down, out, width, x);
+}
+
+// 8 cells per vector
+__attribute__((target("avx512f")))
+static void ConwayRowAvx512(float const *up, float const *row, float const *down, float *out, int const width)
+{
+    __m512 const zero = _mm512_setzero_ps();
+    __m512 const one = _mm512_set1_ps(1);
+    __m512 const two = _mm512_set1_ps(2);
+    __m512 const three = _mm512_set1_ps(3);
+    __m512 const decay = _mm512_set1_ps(.99f);
+
+    ConwayCell(up, row, down, out, width, 0);
+
+    int x = 1;
+    for (; x + 8 < width; x += 8) {
+        float const *u = up + 2*x, *c = row + 2*x, *d = down + 2*x;
+
+        __m512 sum = _mm512_add_ps(_mm512_loadu_ps(u - 2), _mm512_loadu_ps(u));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(u + 2));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(c - 2));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(c + 2));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(d - 2));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(d));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(d + 2));
+
+        __m512 const center = _mm512_loadu_ps(c);
+        __m512 const moore = _mm512_moveldup_ps(sum);
+        __m512 const value = _mm512_moveldup_ps(center);
+        __m512 const heat = _mm512_movehdup_ps(center);
+
+        __mmask16 const alive = _mm512_cmp_ps_mask(value, zero, _CMP_NEQ_UQ);
+        __mmask16 const is3 = _mm512_cmp_ps_mask(moore, three, _CMP_EQ_OQ);
+        __mmask16 const is2 = _mm512_cmp_ps_mask(moore, two, _CMP_EQ_OQ);
+        __mmask16 const survive = alive & (is2 | is3);
+        __mmask16 const birth = ~alive & is3;
+
+        __m512 const newValue = _mm512_maskz_mov_ps(survive | birth, one);
+        __m512 const newHeat = _mm512_mask_mov_ps(_mm512_maskz_mov_ps(birth, one), survive,
+                                                  _mm512_mul_ps(heat, decay));
+
+        _mm512_storeu_ps(out + 2*x, _mm512_mask_blend_ps(0xAAAA, newValue, newHeat));
+    }
+
+    for (; x < width; x++)
+        ConwayCell(up, row, down, out, width, x);
+}
+
+__attribute__((target("avx2")))
+static void SmoothRowAvx2(float const *up, float const *row, float const *down, float *out, int const width,
+                          struct SmoothRule const rule)
+{
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const one = _mm256_set1_ps(1);
+    __m256 const min_perp = _mm256_set1_ps(rule.min_perp);
+    __m256 const max_perp = _mm256_set1_ps(rule.max_perp);
+    __m256 const min_spawn = _mm256_set1_ps(rule.min_spawn);
+    __m256 const max_spawn = _mm256_set1_ps(rule.max_spawn);
+
+    SmoothCell(up, row, down, out, width, 0, rule);
+
+    int x = 1;
+    for (; x + 8 < width; x += 8) {
+        float const *u = up + x, *c = row + x, *d = down + x;
+
+        __m256 moore = _mm256_add_ps(_mm256_loadu_ps(u - 1), _mm256_loadu_ps(u));
+        moore = _mm256_add_ps(moore, _mm256_loadu_ps(u + 1));
+        moore = _mm256_add_ps(moore, _mm256_loadu_ps(c - 1));
+        moore = _mm256_add_ps(moore, _mm256_loadu_ps(c + 1));
+        moore = _mm256_add_ps(moore, _mm256_loadu_ps(d - 1));
+        moore = _mm256_add_ps(moore, _mm256_loadu_ps(d));
+        moore = _mm256_add_ps(moore, _mm256_loadu_ps(d + 1));
+
+        __m256 const value = _mm256_loadu_ps(c);
+        __m256 const alive = _mm256_cmp_ps(value, zero, _CMP_NEQ_UQ);
+        __m256 const perp = _mm256_and_ps(_mm256_cmp_ps(moore, min_perp, _CMP_GE_OQ),
+                                          _mm256_cmp_ps(moore, max_perp, _CMP_LE_OQ));
+        __m256 const spawn = _mm256_and_ps(_mm256_cmp_ps(moore, min_spawn, _CMP_GE_OQ),
+                                           _mm256_cmp_ps(moore, max_spawn, _CMP_LE_OQ));
+
+        __m256 const next = _mm256_or_ps(
+                _mm256_and_ps(_mm256_and_ps(alive, perp), value),
+                _mm256_and_ps(_mm256_andnot_ps(alive, spawn), one));
+        _mm256_storeu_ps(out + x, next);
+    }
+
+    for (; x < width; x++)
+        SmoothCell(up, row, down, out, width, x, rule);
+}
+
+__attribute__((target("avx512f")))
+static void SmoothRowAvx512(float const *up, float const *row, float const *down, float *out, int const width,
+                            struct SmoothRule const rule)
+{
+    __m512 const zero = _mm512_setzero_ps();
+    __m512 const one = _mm512_set1_ps(1);
+    __m512 const min_perp = _mm512_set1_ps(rule.min_perp);
+    __m512 const max_perp = _mm512_set1_ps(rule.max_perp);
+    __m512 const min_spawn = _mm512_set1_ps(rule.min_spawn);
+    __m512 const max_spawn = _mm512_set1_ps(rule.max_spawn);
+
+    SmoothCell(up, row, down, out, width, 0, rule);
+
+    int x = 1;
+    for (; x + 16 < width; x += 16) {
+        float const *u = up + x, *c = row + x, *d = down + x;
+
+        __m512 moore = _mm512_add_ps(_mm512_loadu_ps(u - 1), _mm512_loadu_ps(u));
+        moore = _mm512_add_ps(moore, _mm512_loadu_ps(u + 1));
+        moore = _mm512_add_ps(moore, _mm512_loadu_ps(c - 1));
+        moore = _mm512_add_ps(moore, _mm512_loadu_ps(c + 1));
+        moore = _mm512_add_ps(moore, _mm512_loadu_ps(d - 1));
+        moore = _mm512_add_ps(moore, _mm512_loadu_ps(d));
+        moore = _mm512_add_ps(moore, _mm512_loadu_ps(d + 1));
+
+        __m512 const value = _mm512_loadu_ps(c);
+        __mmask16 const alive = _mm512_cmp_ps_mask(value, zero, _CMP_NEQ_UQ);
+        __mmask16 const perp = _mm512_cmp_ps_mask(moore, min_perp, _CMP_GE_OQ)
+                             & _mm512_cmp_ps_mask(moore, max_perp, _CMP_LE_OQ);
+        __mmask16 const spawn = _mm512_cmp_ps_mask(moore, min_spawn, _CMP_GE_OQ)
+                              & _mm512_cmp_ps_mask(moore, max_spawn, _CMP_LE_OQ);
+
+        __m512 const next = _mm512_mask_mov_ps(_mm512_maskz_mov_ps(~alive & spawn, one), alive & perp, value);
+        _mm512_storeu_ps(out + x, next);
+    }
+
+    for (; x < width; x++)
+        SmoothCell(up, row, down, out, width, x, rule);
+}
+
+#endif
+
+static int const KERNEL_SCALAR = 0, KERNEL_AVX2 = 1, KERNEL_AVX512 = 2;
+
+static int SelectKernel(void)
+{
+    static int selected = -1;
+    if (selected < 0) {
+        selected = KERNEL_SCALAR;
+#ifdef GOL_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            selected = KERNEL_AVX512;
+        else if (__builtin_cpu_supports("avx2"))
+            selected = KERNEL_AVX2;
+#endif
+    }
+    return selected;
+}
+
+const char * VectorKernelName(void)
+{
+    static const char * const names[] = {"scalar", "avx2", "avx512"};
+    return names[SelectKernel()];
+}
+
+static ConwayRowKernel ConwayKernel(void)
+{
+#ifdef GOL_X86_KERNELS
+    if (SelectKernel() == KERNEL_AVX512)
+        return ConwayRowAvx512;
+    if (SelectKernel() == KERNEL_AVX2)
+        return ConwayRowAvx2;
+#endif
+    return ConwayRowScalar;
+}
+
+static SmoothRowKernel SmoothKernel(void)
+{
+#ifdef GOL_X86_KERNELS
+    if (SelectKernel() == KERNEL_AVX512)
+        return SmoothRowAvx512;
+    if (SelectKernel() == KERNEL_AVX2)
+        return SmoothRowAvx2;
+#endif
+    return SmoothRowScalar;
+}
+
+void IterateConwayVectorizedRows(int const height, int const width,
+                                 float const (*pixelData)[height][width][2], float (*newPixelData)[height][width][2],
+                                 int const begin, int const end)
+{
+    ConwayRowKernel const kernel = ConwayKernel();
+
+    // the torus wrap only concerns the first and last rows
+    for (int y = begin; y < end; ++y) {
+        int const up = y == 0 ? height - 1 : y - 1;
+        int const down = y == height - 1 ? 0 : y + 1;
+        kernel((*pixelData)[up][0], (*pixelData)[y][0], (*pixelData)[down][0], (*newPixelData)[y][0], width);
+    }
+}
+
+void IterateConwayVectorized(int const height, int const width,
+                             float const (*pixelData)[height][width][2], float (*newPixelData)[height][width][2])
+{
+    IterateConwayVectorizedRows(height, width, pixelData, newPixelData, 0, height);
+}
+
+void IterateSmoothworldVectorizedRows(int const height, int const width,
+                                      float const (*pixelData)[height][width], float (*newPixelData)[height][width],
+                                      float const min_perp, float const max_perp,
+                                      float const min_spawn, float const max_spawn,
+                                      int const begin, int const end)
+{
+    SmoothRowKernel const kernel = SmoothKernel();
+    struct SmoothRule const rule = {min_perp, max_perp, min_spawn, max_spawn};
+
+    for (int y = begin; y < end; ++y) {
+        int const up = y == 0 ? height - 1 : y - 1;
+        int const down = y == height - 1 ? 0 : y + 1;
+        kernel((*pixelData)[up], (*pixelData)[y], (*pixelData)[down], (*newPixelData)[y], width, rule);
+    }
+}
+
+void IterateSmoothworldVectorized(int const height, int const width,
+                                  float (*pixelData)[height][width], float (*newPixelData)[height][width],
+                                  float const min_perp, float const max_perp,
+                                  float const min_spawn, float const max_spawn)
+{
+    IterateSmoothworldVectorizedRows(height, width, pixelData, newPixelData,
+                                     min_perp, max_perp, min_spawn, max_spawn, 0, height);
+
+    memcpy(pixelData, newPixelData, sizeof *newPixelData);
+}
@@ -0,0 +1,29 @@
+//
+// SIMD kernels for the float grids of IterateConway and IterateSmoothworld.
+//
+
+#ifndef GOL_VECTORIZED_H
+#define GOL_VECTORIZED_H
+
+// "avx512", "avx2" or "scalar", picked once from the running CPU
+const char * VectorKernelName(void);
+
+// same result as IterateConway(..., CONWAY_LIFE_RULE), value + heat
+void IterateConwayVectorized(int height, int width,
+                             float const (*pixelData)[height][width][2], float (*newPixelData)[height][width][2]);
+
+// same result as IterateSmoothworld(..., conway_rule, ...), copies newPixelData back like it does
+void IterateSmoothworldVectorized(int height, int width,
+                                  float (*pixelData)[height][width], float (*newPixelData)[height][width],
+                                  float min_perp, float max_perp, float min_spawn, float max_spawn);
+
+// rows [begin, end) only, for banded stepping; the SmoothWorld one does not copy back
+void IterateConwayVectorizedRows(int height, int width,
+                                 float const (*pixelData)[height][width][2], float (*newPixelData)[height][width][2],
+                                 int begin, int end);
+void IterateSmoothworldVectorizedRows(int height, int width,
+                                      float const (*pixelData)[height][width], float (*newPixelData)[height][width],
+                                      float min_perp, float max_perp, float min_spawn, float max_spawn,
+                                      int begin, int end);
+
+#endif //GOL_VECTORIZED_H
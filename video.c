@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "video.h"
+#include "timing.h"
+
+// frames copied and not written yet, at most
+#define VIDEO_QUEUE 4
+
+struct VideoWriter {
+    struct VideoSettings settings;
+    FILE *file;
+    size_t state_size;
+    unsigned char *states; // VIDEO_QUEUE of state_size, used round robin
+    unsigned char *levels; // one byte per cell, an index in lut
+    unsigned char *pixels; // RGB of each cell for ppm, the Y, U and V planes one after the other for y4m
+    unsigned char lut[256][3];
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t room;
+    uint64_t queued;
+    uint64_t written;
+    bool stop;
+    bool failed;
+    struct VideoStats stats;
+};
+
+static size_t StateSize(struct VideoSettings const *settings)
+{
+    size_t const cells = (size_t)settings->height * settings->width;
+    switch (settings->source) {
+    case VIDEO_BITS:
+        return (size_t)settings->height * ((settings->width + 63) / 64) * sizeof(uint64_t);
+    case VIDEO_ALIVE_HEAT:
+        return cells * 2 * sizeof(float);
+    case VIDEO_INTENSITY:
+        return cells * sizeof(float);
+    }
+    return 0;
+}
+
+// the colour of each level : 0 dead, then the intensity, or 1 + the heat of a living cell on 254 levels
+static void FillVideoLut(struct VideoWriter *writer)
+{
+    struct VideoPalette const *palette = &writer->settings.palette;
+
+    for (int level = 0; level < 256; ++level) {
+        int rgb[3];
+        for (int c = 0; c < 3; ++c) {
+            if (writer->settings.source != VIDEO_ALIVE_HEAT)
+                rgb[c] = palette->dead[c] + ((palette->alive[c] - palette->dead[c]) * level + 127) / 255;
+            else if (level == 0)
+                rgb[c] = palette->dead[c];
+            else
+                rgb[c] = c == 0 ? palette->alive[c] : palette->alive[c] * (508 - (level - 1)) / 508;
+        }
+
+        if (writer->settings.format == VIDEO_PPM) {
+            for (int c = 0; c < 3; ++c)
+                writer->lut[level][c] = (unsigned char)rgb[c];
+        } else {
+            // BT.601, the video range
+            int const r = rgb[0], g = rgb[1], b = rgb[2];
+            writer->lut[level][0] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            writer->lut[level][1] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            writer->lut[level][2] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static void StateLevels(struct VideoWriter *writer, unsigned char const *state)
+{
+    int const height = writer->settings.height, width = writer->settings.width;
+    unsigned char *level = writer->levels;
+
+    switch (writer->settings.source) {
+    case VIDEO_BITS: {
+        int const words = (width + 63) / 64;
+        for (int y = 0; y < height; ++y) {
+            uint64_t const *row = (uint64_t const *)state + (size_t)y * words;
+            for (int x = 0; x < width; ++x)
+                *level++ = row[x / 64] >> (x % 64) & 1 ? 255 : 0;
+        }
+        break;
+    }
+    case VIDEO_ALIVE_HEAT: {
+        float const *cell = (float const *)state;
+        for (size_t i = 0; i < (size_t)height * width; ++i, cell += 2) {
+            float const heat = cell[1] >= 1 ? 1 : cell[1] <= 0 ? 0 : cell[1];
+            *level++ = cell[0] > FLT_EPSILON ? (unsigned char)(1 + (int)(heat * 254 + .5f)) : 0;
+        }
+        break;
+    }
+    case VIDEO_INTENSITY: {
+        float const *cell = (float const *)state;
+        for (size_t i = 0; i < (size_t)height * width; ++i) {
+            float const intensity = cell[i];
+            *level++ = (unsigned char)(intensity >= 1 ? 255 : intensity <= 0 ? 0 : intensity * 255 + .5f);
+        }
+        break;
+    }
+    }
+}
+
+static bool WriteVideoFrame(struct VideoWriter *writer, unsigned char const *state)
+{
+    size_t const cells = (size_t)writer->settings.height * writer->settings.width;
+    StateLevels(writer, state);
+
+    if (writer->settings.format == VIDEO_PPM) {
+        for (size_t i = 0; i < cells; ++i)
+            memcpy(writer->pixels + 3 * i, writer->lut[writer->levels[i]], 3);
+        if (fprintf(writer->file, "P6\n%d %d\n255\n", writer->settings.width, writer->settings.height) < 0)
+            return false;
+    } else {
+        for (int plane = 0; plane < 3; ++plane)
+            for (size_t i = 0; i < cells; ++i)
+                writer->pixels[plane * cells + i] = writer->lut[writer->levels[i]][plane];
+        if (fputs("FRAME\n", writer->file) < 0)
+            return false;
+    }
+    return fwrite(writer->pixels, 3, cells, writer->file) == cells;
+}
+
+static void * VideoLoop(void *argument)
+{
+    struct VideoWriter *writer = argument;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (writer->written == writer->queued && !writer->stop)
+            pthread_cond_wait(&writer->ready, &writer->lock);
+        if (writer->written == writer->queued)
+            break;
+        unsigned char const *state = writer->states + writer->written % VIDEO_QUEUE * writer->state_size;
+        pthread_mutex_unlock(&writer->lock);
+
+        // the slot is ours until written moves past it
+        double const start = WallSeconds();
+        bool const ok = WriteVideoFrame(writer, state);
+        double const seconds = WallSeconds() - start;
+
+        pthread_mutex_lock(&writer->lock);
+        writer->failed |= !ok;
+        writer->stats.encoding += seconds;
+        writer->written++;
+        pthread_cond_signal(&writer->room);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return nullptr;
+}
+
+FILE * ClaimStdout(void)
+{
+    fflush(stdout);
+#ifdef _WIN32
+    int const fd = _dup(_fileno(stdout));
+    if (fd < 0 || _dup2(_fileno(stderr), _fileno(stdout)) < 0)
+        return nullptr;
+    _setmode(fd, _O_BINARY);
+    return _fdopen(fd, "wb");
+#else
+    int const fd = dup(STDOUT_FILENO);
+    if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+        return nullptr;
+    return fdopen(fd, "wb");
+#endif
+}
+
+static void FreeVideoMemory(struct VideoWriter *writer)
+{
+    free(writer->states);
+    free(writer->levels);
+    free(writer->pixels);
+    free(writer);
+}
+
+struct VideoWriter * CreateVideoWriter(struct VideoSettings const *settings)
+{
+    struct VideoWriter *writer = calloc(1, sizeof *writer);
+    if (writer == nullptr)
+        return nullptr;
+
+    size_t const cells = (size_t)settings->height * settings->width;
+    writer->settings = *settings;
+    writer->state_size = StateSize(settings);
+    writer->states = malloc(VIDEO_QUEUE * writer->state_size);
+    writer->levels = malloc(cells);
+    writer->pixels = malloc(3 * cells);
+    if (writer->states == nullptr || writer->levels == nullptr || writer->pixels == nullptr
+        || (writer->file = settings->file != nullptr ? settings->file : fopen(settings->path, "wb")) == nullptr) {
+        FreeVideoMemory(writer);
+        return nullptr;
+    }
+    FillVideoLut(writer);
+    if (settings->format == VIDEO_Y4M)
+        fprintf(writer->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", settings->width, settings->height,
+                settings->rate);
+
+    pthread_mutex_init(&writer->lock, nullptr);
+    pthread_cond_init(&writer->ready, nullptr);
+    pthread_cond_init(&writer->room, nullptr);
+    if (pthread_create(&writer->thread, nullptr, VideoLoop, writer) != 0) {
+        fclose(writer->file);
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->ready);
+        pthread_cond_destroy(&writer->room);
+        FreeVideoMemory(writer);
+        return nullptr;
+    }
+    return writer;
+}
+
+void QueueVideoFrame(struct VideoWriter *writer, void const *state)
+{
+    pthread_mutex_lock(&writer->lock);
+    if (writer->queued - writer->written == VIDEO_QUEUE) {
+        double const start = WallSeconds();
+        while (writer->queued - writer->written == VIDEO_QUEUE)
+            pthread_cond_wait(&writer->room, &writer->lock);
+        writer->stats.blocked += WallSeconds() - start;
+    }
+    unsigned char *slot = writer->states + writer->queued % VIDEO_QUEUE * writer->state_size;
+    pthread_mutex_unlock(&writer->lock);
+
+    // the thread is done with that slot, it does not look at it before queued moves
+    memcpy(slot, state, writer->state_size);
+
+    pthread_mutex_lock(&writer->lock);
+    writer->queued++;
+    pthread_cond_signal(&writer->ready);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+bool FreeVideoWriter(struct VideoWriter *writer, struct VideoStats *stats)
+{
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = true;
+    pthread_cond_signal(&writer->ready);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, nullptr);
+
+    bool const ok = fclose(writer->file) == 0 && !writer->failed;
+    *stats = writer->stats;
+    stats->frames = writer->written;
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->ready);
+    pthread_cond_destroy(&writer->room);
+    FreeVideoMemory(writer);
+    return ok;
+}
@@ -0,0 +1,58 @@
+//
+// Raw video of a run without a window or a GPU : a palette pass on the CPU and a thread writing the frames.
+//
+
+#ifndef GOL_VIDEO_H
+#define GOL_VIDEO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+enum VideoFormat {
+    VIDEO_Y4M, // YUV4MPEG2 4:4:4, what ffmpeg and x264 read from a pipe
+    VIDEO_PPM, // P6 images one after the other, ffmpeg -f image2pipe
+};
+
+// the state handed to QueueVideoFrame, as the engine keeps it
+enum VideoSource {
+    VIDEO_BITS, // the words of a BitGrid, 64 cells per uint64_t
+    VIDEO_ALIVE_HEAT, // float[height][width][2], value and heat of the float Conway engines
+    VIDEO_INTENSITY, // float[height][width], smooth and lenia, clamped to [0, 1]
+};
+
+struct VideoPalette {
+    unsigned char dead[3];
+    unsigned char alive[3]; // a cell at full intensity, the heat of VIDEO_ALIVE_HEAT fades its green and blue down to half
+};
+
+struct VideoSettings {
+    char const *path; // opened for the frames
+    FILE *file; // written instead of path unless nullptr, ClaimStdout for a pipe
+    enum VideoFormat format;
+    enum VideoSource source;
+    int height;
+    int width;
+    int rate; // frames per second written in the stream
+    struct VideoPalette palette;
+};
+
+struct VideoStats {
+    uint64_t frames;
+    double blocked; // seconds QueueVideoFrame waited for room
+    double encoding; // seconds of the writer thread, palette and writes
+};
+
+struct VideoWriter;
+
+// stdout for the frames, what the program prints goes to stderr from then on; nullptr when it cannot be had
+FILE * ClaimStdout(void);
+
+// opens the stream and starts its thread, nullptr when either fails
+struct VideoWriter * CreateVideoWriter(struct VideoSettings const *settings);
+// copies state and returns, waits only when the thread is VIDEO_QUEUE frames behind; never drops one
+void QueueVideoFrame(struct VideoWriter *writer, void const *state);
+// writes the frames still queued and closes the stream, false when one of them could not be written
+bool FreeVideoWriter(struct VideoWriter *writer, struct VideoStats *stats);
+
+#endif //GOL_VIDEO_H
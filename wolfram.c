@@ -0,0 +1,280 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+#include "wolfram.h"
+#include "bitlife.h"
+#include "lifeword.h"
+
+void IterateWolf(int const height, int const width, float (*pixelColors)[height][width][2], unsigned char const pattern, int const line)
+{
+    for (int x = 0; x < width; x++) {
+        int const previous = ((int)(*pixelColors)[(height + line-1) % height][(width + x-1) % width][0] << 2)
+                       + ((int)(*pixelColors)[(height + line-1) % height][x][0] << 1)
+                       + ((int)(*pixelColors)[(height + line-1) % height][(x+1) % width][0] << 0);
+        assert(previous >= 0 && previous <= 7);
+
+        (*pixelColors)[line][x][0] = (_Bool )(pattern & (1 << previous));
+    }
+}
+
+void InitWolf(int height, int width, float (*pixelColors)[height][width][2], unsigned char pattern) {
+    for (int i = 0; i < width; i++) {
+        //(*pixelColors)[0][i] = rand() & 1;
+        (*pixelColors)[0][i][0] = 0;
+        (*pixelColors)[0][i][1] = 0;
+    }
+    (*pixelColors)[0][width/2][0] = 1;
+    (*pixelColors)[0][width/2][1] = 1;
+
+    for (int y = 1; y < height; ++y) {
+        IterateWolf(height, width, pixelColors, pattern, y);
+    }
+}
+
+struct WolfRow CreateWolfRow(int const width)
+{
+    int const words = (width + 63) / 64;
+    return (struct WolfRow){width, words, calloc(words, sizeof(uint64_t))};
+}
+
+void FreeWolfRow(struct WolfRow *row)
+{
+    free(row->cells);
+    row->cells = nullptr;
+}
+
+void InitWolfRow(struct WolfRow *row)
+{
+    memset(row->cells, 0, row->words * sizeof *row->cells);
+    row->cells[row->width / 2 / 64] = (uint64_t)1 << (row->width / 2 % 64);
+}
+
+// out of the 8 bits of the rule, one per neighbourhood, with three levels of multiplexers on right, centre and left
+static inline uint64_t Select(uint64_t const when0, uint64_t const when1, uint64_t const bit)
+{
+    return when0 ^ ((when0 ^ when1) & bit);
+}
+
+uint64_t StepWolfRow(unsigned char const rule, struct WolfRow const *row, struct WolfRow *next)
+{
+    uint64_t m[8];
+    for (int k = 0; k < 8; ++k)
+        m[k] = -(uint64_t)(rule >> k & 1);
+
+    int const words = row->words, last = (row->width - 1) % 64;
+    uint64_t const *cells = row->cells;
+    uint64_t const tail = last == 63 ? ~(uint64_t)0 : ((uint64_t)1 << (last + 1)) - 1;
+    uint64_t population = 0;
+
+    for (int j = 0; j < words; ++j) {
+        uint64_t const c = cells[j];
+        // left is cell x - 1, bit 2 of the neighbourhood in IterateWolf, right is cell x + 1
+        uint64_t const left = c << 1 | (j > 0 ? cells[j - 1] >> 63 : cells[words - 1] >> last & 1);
+        uint64_t const right = j < words - 1 ? c >> 1 | cells[j + 1] << 63 : c >> 1 | (cells[0] & 1) << last;
+
+        uint64_t const lc00 = Select(m[0], m[1], right), lc01 = Select(m[2], m[3], right);
+        uint64_t const lc10 = Select(m[4], m[5], right), lc11 = Select(m[6], m[7], right);
+        uint64_t word = Select(Select(lc00, lc01, c), Select(lc10, lc11, c), left);
+
+        if (j == words - 1)
+            word &= tail;
+        next->cells[j] = word;
+        population += PopCount64(word);
+    }
+    return population;
+}
+
+uint64_t CountWolfRow(struct WolfRow const *row)
+{
+    uint64_t population = 0;
+    for (int j = 0; j < row->words; ++j)
+        population += PopCount64(row->cells[j]);
+    return population;
+}
+
+uint64_t HashWolfRow(struct WolfRow const *row)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int j = 0; j < row->words; ++j)
+        hash = (hash ^ row->cells[j]) * 0x100000001B3ull;
+    return hash;
+}
+
+void UnpackWolfRow(struct WolfRow const *row, unsigned char *texels)
+{
+    for (int x = 0; x < row->width; ++x)
+        texels[x] = (unsigned char)-(int)(row->cells[x / 64] >> (x % 64) & 1);
+}
+
+static inline int WolfCell(uint64_t const *cells, int const x)
+{
+    return (int)(cells[x / 64] >> (x % 64) & 1);
+}
+
+// the window sum of cell 0 once, then one cell in and one cell out per cell, whatever the radius;
+// radius and outer are constants in each copy
+RULE_INLINE uint64_t SlideWolfRow(struct WolfRule const rule, int const radius, bool const outer,
+                                  struct WolfRow const *row, struct WolfRow *next)
+{
+    int const width = row->width, words = row->words;
+    uint64_t const *cells = row->cells;
+
+    // a row narrower than the window wraps around it several times, cells count once per time
+    int sum = 0;
+    for (int d = -radius; d <= radius; ++d)
+        sum += WolfCell(cells, ((d % width) + width) % width);
+    int in = (radius + 1) % width, out = (width - radius % width) % width;
+
+    uint64_t population = 0;
+    for (int j = 0; j < words; ++j) {
+        int const count = j == words - 1 ? width - 64 * j : 64;
+        uint64_t const c = cells[j];
+        uint64_t word = 0;
+
+        for (int b = 0; b < count; ++b) {
+            int const alive = (int)(c >> b & 1);
+            uint16_t const next_for = outer && alive ? rule.survival : rule.birth;
+            word |= (uint64_t)(next_for >> (outer ? sum - alive : sum) & 1) << b;
+
+            sum += WolfCell(cells, in) - WolfCell(cells, out);
+            if (++in == width)
+                in = 0;
+            if (++out == width)
+                out = 0;
+        }
+
+        next->cells[j] = word;
+        population += PopCount64(word);
+    }
+    return population;
+}
+
+#define WOLF_KERNELS(radius) \
+    static uint64_t StepWolf_Totalistic##radius(struct WolfRule const rule, struct WolfRow const *row, \
+                                                struct WolfRow *next) \
+    { \
+        return SlideWolfRow(rule, radius, false, row, next); \
+    } \
+    static uint64_t StepWolf_Outer##radius(struct WolfRule const rule, struct WolfRow const *row, \
+                                           struct WolfRow *next) \
+    { \
+        return SlideWolfRow(rule, radius, true, row, next); \
+    }
+
+#define WOLF_RADII(X) X(1) X(2) X(3) X(4)
+
+WOLF_RADII(WOLF_KERNELS)
+
+static uint64_t StepWolf_Elementary(struct WolfRule const rule, struct WolfRow const *row, struct WolfRow *next)
+{
+    return StepWolfRow((unsigned char)rule.birth, row, next);
+}
+
+#define WOLF_ENTRY(radius) \
+    {"totalistic r" #radius, StepWolf_Totalistic##radius}, \
+    {"outer totalistic r" #radius, StepWolf_Outer##radius},
+
+// two per radius from 1, totalistic first
+static struct {
+    char const *name;
+    uint64_t (*step)(struct WolfRule rule, struct WolfRow const *row, struct WolfRow *next);
+} const wolf_kernels[] = {
+    WOLF_RADII(WOLF_ENTRY)
+};
+
+static_assert(sizeof wolf_kernels / sizeof *wolf_kernels == 2 * WOLF_MAX_RADIUS, "a kernel per radius and class");
+
+struct WolfKernel SelectWolfKernel(struct WolfRule const rule)
+{
+    if (rule.kind == WOLF_ELEMENTARY)
+        return (struct WolfKernel){rule, "elementary", StepWolf_Elementary};
+
+    int const index = 2 * (rule.radius - 1) + (rule.kind == WOLF_OUTER_TOTALISTIC);
+    return (struct WolfKernel){rule, wolf_kernels[index].name, wolf_kernels[index].step};
+}
+
+uint64_t StepWolfKernel(struct WolfKernel const *kernel, struct WolfRow const *row, struct WolfRow *next)
+{
+    return kernel->step(kernel->rule, row, next);
+}
+
+// digits 0 to max until the first character that is not one
+static char const * ParseSums(char const *text, int const max, uint16_t *sums)
+{
+    *sums = 0;
+    for (; *text >= '0' && *text <= '0' + max; ++text)
+        *sums |= 1 << (*text - '0');
+    return text;
+}
+
+bool ParseWolfRule(char const *text, struct WolfRule *rule)
+{
+    struct WolfRule parsed = {0};
+    char *end;
+
+    if (toupper((unsigned char)*text) == 'W') {
+        long const code = strtol(text + 1, &end, 10);
+        if (end == text + 1 || *end != '\0' || code < 0 || code > 255)
+            return false;
+        *rule = WOLF_ELEMENTARY_RULE((uint16_t)code);
+        return true;
+    }
+
+    if (toupper((unsigned char)*text) != 'R')
+        return false;
+    parsed.radius = (int)strtol(text + 1, &end, 10);
+    if (end == text + 1 || parsed.radius < 1 || parsed.radius > WOLF_MAX_RADIUS || *end != '/')
+        return false;
+    text = end + 1;
+
+    if (toupper((unsigned char)*text) == 'T') {
+        // bit s for a window of 2r + 1 cells summing to s
+        long const code = strtol(text + 1, &end, 10);
+        if (end == text + 1 || code < 0 || code >= 1l << (2 * parsed.radius + 2))
+            return false;
+        parsed.kind = WOLF_TOTALISTIC;
+        parsed.birth = (uint16_t)code;
+        text = end;
+    } else if (toupper((unsigned char)*text) == 'B') {
+        parsed.kind = WOLF_OUTER_TOTALISTIC;
+        text = ParseSums(text + 1, 2 * parsed.radius, &parsed.birth);
+        if (*text == '/')
+            ++text;
+        if (toupper((unsigned char)*text) != 'S')
+            return false;
+        text = ParseSums(text + 1, 2 * parsed.radius, &parsed.survival);
+    } else {
+        return false;
+    }
+
+    if (*text != '\0')
+        return false;
+    *rule = parsed;
+    return true;
+}
+
+void FormatWolfRule(struct WolfRule const rule, char text[static 32])
+{
+    if (rule.kind == WOLF_ELEMENTARY) {
+        sprintf(text, "W%d", rule.birth & 0xff);
+        return;
+    }
+    if (rule.kind == WOLF_TOTALISTIC) {
+        sprintf(text, "R%d/T%d", rule.radius, rule.birth);
+        return;
+    }
+
+    int k = sprintf(text, "R%d/B", rule.radius);
+    for (int s = 0; s <= 2 * rule.radius; ++s)
+        if (rule.birth >> s & 1)
+            text[k++] = (char)('0' + s);
+    text[k++] = '/';
+    text[k++] = 'S';
+    for (int s = 0; s <= 2 * rule.radius; ++s)
+        if (rule.survival >> s & 1)
+            text[k++] = (char)('0' + s);
+    text[k] = '\0';
+}
@@ -0,0 +1,72 @@
+//
+// One dimensional automata, elementary and radius-r totalistic, one row of the board per generation.
+//
+
+#ifndef GOL_WOLFRAM_H
+#define GOL_WOLFRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// row 0 is a single cell in the middle, the other rows follow from it
+void InitWolf(int height, int width, float (*pixelColors)[height][width][2], unsigned char pattern);
+// computes row line from the one above it, wrapping around both ways
+void IterateWolf(int height, int width, float (*pixelColors)[height][width][2], unsigned char pattern, int line);
+
+// one generation of 64 cells per word, cell x is bit x % 64 of word x / 64, the bits past width stay 0
+struct WolfRow {
+    int width;
+    int words;
+    uint64_t *cells;
+};
+
+// cells is nullptr when it cannot be allocated
+struct WolfRow CreateWolfRow(int width);
+void FreeWolfRow(struct WolfRow *row);
+
+// a single cell in the middle, like row 0 of InitWolf
+void InitWolfRow(struct WolfRow *row);
+// the generation after row into next, the same width, any of the 256 rules; returns its population
+uint64_t StepWolfRow(unsigned char rule, struct WolfRow const *row, struct WolfRow *next);
+uint64_t CountWolfRow(struct WolfRow const *row);
+// FNV-1a of the words
+uint64_t HashWolfRow(struct WolfRow const *row);
+// one byte per cell, 255 alive and 0 dead, for a GL_R8 texture row
+void UnpackWolfRow(struct WolfRow const *row, unsigned char *texels);
+
+#define WOLF_MAX_RADIUS 4
+
+enum WolfRuleClass {
+    WOLF_ELEMENTARY, // the 8 bit Wolfram code, radius 1
+    WOLF_TOTALISTIC, // from the sum of the 2r + 1 cells of the window, centre included
+    WOLF_OUTER_TOTALISTIC, // from the centre and the sum of its 2r neighbours
+};
+
+struct WolfRule {
+    enum WolfRuleClass kind;
+    int radius; // 1 to WOLF_MAX_RADIUS
+    // elementary : the Wolfram code; totalistic : bit s alive after a window summing to s;
+    // outer totalistic : bit s gives birth to a dead cell with s living neighbours
+    uint16_t birth;
+    uint16_t survival; // outer totalistic : bit s keeps a living cell with s living neighbours
+};
+
+#define WOLF_ELEMENTARY_RULE(code) ((struct WolfRule){.kind = WOLF_ELEMENTARY, .radius = 1, .birth = (code)})
+
+// "W30", "R2/T52" for the totalistic code 52, "R3/B1/S012" outer totalistic; false when the text is not one
+bool ParseWolfRule(char const *text, struct WolfRule *rule);
+// the same forms, 31 characters at most
+void FormatWolfRule(struct WolfRule rule, char text[static 32]);
+
+// one copy of the loop per radius and class, the window sum slides along the row and costs the same at any radius
+struct WolfKernel {
+    struct WolfRule rule;
+    char const *name; // "elementary", "totalistic r2", "outer totalistic r3"
+    uint64_t (*step)(struct WolfRule rule, struct WolfRow const *row, struct WolfRow *next);
+};
+
+struct WolfKernel SelectWolfKernel(struct WolfRule rule);
+// the generation after row into next, returns its population
+uint64_t StepWolfKernel(struct WolfKernel const *kernel, struct WolfRow const *row, struct WolfRow *next);
+
+#endif //GOL_WOLFRAM_H
@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "workers.h"
+
+struct Worker {
+    struct WorkerPool *pool;
+    int index;
+};
+
+struct WorkerPool {
+    int count;
+    pthread_t *threads;
+    struct Worker *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+
+    long generation; // bumped by every RunBands
+    int pending; // workers still inside the current generation
+    bool stop;
+
+    BandTask task;
+    WorkerBandTask worker_task; // instead of task when not nullptr
+    void *context;
+    int items;
+};
+
+int HardwareThreadCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long const count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static void RunBand(struct WorkerPool const *pool, int const index)
+{
+    int const begin = (int)((long long)pool->items * index / pool->count);
+    int const end = (int)((long long)pool->items * (index + 1) / pool->count);
+    if (begin < end && pool->worker_task != nullptr)
+        pool->worker_task(pool->context, index, begin, end);
+    else if (begin < end)
+        pool->task(pool->context, begin, end);
+}
+
+static void * WorkerLoop(void *argument)
+{
+    struct Worker const *worker = argument;
+    struct WorkerPool *pool = worker->pool;
+    long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stop)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->stop)
+            break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        RunBand(pool, worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return nullptr;
+}
+
+struct WorkerPool * CreateWorkerPool(int threads)
+{
+    if (threads <= 0)
+        threads = HardwareThreadCount();
+
+    struct WorkerPool *pool = calloc(1, sizeof *pool);
+    if (pool == nullptr)
+        return nullptr;
+
+    pool->count = threads;
+    pool->threads = calloc(threads, sizeof *pool->threads);
+    pool->workers = calloc(threads, sizeof *pool->workers);
+    if (pool->threads == nullptr || pool->workers == nullptr) {
+        free(pool->threads);
+        free(pool->workers);
+        free(pool);
+        return nullptr;
+    }
+
+    pthread_mutex_init(&pool->lock, nullptr);
+    pthread_cond_init(&pool->start, nullptr);
+    pthread_cond_init(&pool->done, nullptr);
+
+    // band 0 runs on the caller of RunBands
+    for (int i = 1; i < threads; ++i) {
+        pool->workers[i] = (struct Worker){pool, i};
+        if (pthread_create(&pool->threads[i], nullptr, WorkerLoop, &pool->workers[i]) != 0) {
+            fprintf(stderr, "fail to start worker %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return pool;
+}
+
+void FreeWorkerPool(struct WorkerPool *pool)
+{
+    if (pool == nullptr)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->count; ++i)
+        pthread_join(pool->threads[i], nullptr);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+}
+
+int WorkerCount(struct WorkerPool const *pool)
+{
+    return pool->count;
+}
+
+static void StartBands(struct WorkerPool *pool, int const items, BandTask const task,
+                       WorkerBandTask const worker_task, void *context)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->worker_task = worker_task;
+    pool->context = context;
+    pool->items = items;
+    pool->pending = pool->count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    RunBand(pool, 0);
+
+    // the only synchronisation point of a generation
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void RunBands(struct WorkerPool *pool, int const items, BandTask const task, void *context)
+{
+    if (pool->count == 1) {
+        if (items > 0)
+            task(context, 0, items);
+        return;
+    }
+    StartBands(pool, items, task, nullptr, context);
+}
+
+void RunWorkerBands(struct WorkerPool *pool, int const items, WorkerBandTask const task, void *context)
+{
+    if (pool->count == 1) {
+        if (items > 0)
+            task(context, 0, 0, items);
+        return;
+    }
+    StartBands(pool, items, nullptr, task, context);
+}
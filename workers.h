@@ -0,0 +1,26 @@
+//
+// Persistent worker pool running one band of rows per thread.
+//
+
+#ifndef GOL_WORKERS_H
+#define GOL_WORKERS_H
+
+// computes the items [begin, end) of one band
+typedef void (*BandTask)(void *context, int begin, int end);
+// the same, with the index of the worker in [0, WorkerCount) for buffers kept per worker
+typedef void (*WorkerBandTask)(void *context, int worker, int begin, int end);
+
+struct WorkerPool;
+
+// threads <= 0 uses every hardware thread, the calling thread counts as one of them
+struct WorkerPool * CreateWorkerPool(int threads);
+void FreeWorkerPool(struct WorkerPool *pool);
+
+int WorkerCount(struct WorkerPool const *pool);
+int HardwareThreadCount(void);
+
+// splits [0, items) in one contiguous band per worker and returns once all of them are done
+void RunBands(struct WorkerPool *pool, int items, BandTask task, void *context);
+void RunWorkerBands(struct WorkerPool *pool, int items, WorkerBandTask task, void *context);
+
+#endif //GOL_WORKERS_H